@@ -0,0 +1,33 @@
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include <Arduino.h>
+
+// Collector mode, for the finish tent: readout tags are read back instead of
+// written. The dump URL on each tag is decoded and its MAC checked on the
+// device, and every run not collected before (by content hash and MAC
+// validity, so a forged copy cannot block the genuine one) is appended to a
+// table on the flash file system. The dedup index lives on the heap only
+// while collecting. "collect dump" streams the table as dump URLs, one per
+// line, which kor-decode and the results server import as they are.
+//
+// A collector never writes readout tags. Build with COLLECTOR_MODE=1
+// (env:d1_mini_collector) to start in collector mode after every boot.
+
+#ifndef COLLECTOR_MODE
+#define COLLECTOR_MODE 0
+#endif
+
+#define COLLECT_MAX_RUNS 500
+#define COLLECT_FILE "/runs.bin"
+
+void startCollecting();
+void stopCollecting();
+bool isCollecting();
+void collectNfcCard(uint8_t reader);
+
+uint16_t collectedRunCount();
+void printCollectedRuns();
+void clearCollectedRuns();
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <Arduino.h>
+#include "storage.h"
+
+// Station profile: the timing and readout settings that used to be compile
+// time constants, so a station can be retuned in the field (mass start,
+// low-traffic rogaine) without reflashing. Loaded from flash at boot into
+// stationConfig, which the hot paths read directly.
+//
+// A configuration tag carries a "KORCFG" text record followed by an NFC
+// Forum external record, type "kor:c", payload [StationConfig][check(4)],
+// little-endian.
+// The check is the low 32 bits of SipHash-2-4 over the profile, keyed with
+// the readout MAC key, so only tags made for this key are applied.
+
+#define CONFIG_VERSION 1
+#define CONFIG_RECORD_TYPE "kor:c"
+#define CONFIG_TEXT "KORCFG"
+#define CONFIG_PREFIX_SIZE 48    // Readout URL prefix after "https://", NUL included
+#define CONFIG_CHECK_SIZE 4
+
+struct __attribute__((packed)) StationConfig {
+  uint8_t version;
+  uint16_t pollInterval;         // ms between poll ticks (see NFC_POLL_MODE)
+  uint8_t loopDelay;             // ms slept at the end of every loop()
+  uint16_t cooldown;             // ms the same tag is ignored after a tap
+  uint8_t logLevel;              // LOG_LEVEL_*, cannot go below the compiled LOG_LEVEL
+  uint8_t lastReadPage;          // A tap reads at least to here, on to the end of the NDEF message
+  char readoutPrefix[CONFIG_PREFIX_SIZE];
+};
+
+#define CONFIG_MIN_READ_PAGE 7   // Pages 4-7 hold a control's text record; longer messages are read whole
+
+extern StationConfig stationConfig;
+
+void loadConfig();
+void resetConfig();              // Back to the compiled defaults, saved
+void printConfig();
+
+// Change one setting by name from the console and save it
+bool setConfigValue(const char* name, const char* value);
+
+// The profile record after a KORCFG text record: validate, apply and save
+bool applyConfigRecord(const uint8_t* record, uint16_t length);
+
+// Length of the host at the start of the readout prefix, with the '/' after
+// it: readout trigger tags are recognised by "https://" and this much
+uint8_t readoutHostLength();
+
+// The active profile as a "kor:c" record (last in its message), for
+// provisioning configuration tags. Returns its length.
+uint16_t buildConfigRecord(uint8_t* record);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <Arduino.h>
+
+// Line-based serial console, see "help" for the commands
+void pollConsole();
+
+#endif
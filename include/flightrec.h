@@ -0,0 +1,52 @@
+#ifndef FLIGHTREC_H
+#define FLIGHTREC_H
+
+#include <Arduino.h>
+#include "storage.h"
+
+// Flight recorder: the raw pages of the last failed tag reads and writes, so
+// a tag that broke in the field can be looked at (and replayed on the host
+// with tools/replay) after the event. Recording only happens on failures;
+// a successful tap costs nothing.
+
+#ifndef FLIGHT_RECORDER_SIZE
+#define FLIGHT_RECORDER_SIZE 8
+#endif
+
+// Also keep the records in flash (EEPROM emulation), so they survive a power
+// cycle. Every failure then commits a flash sector.
+#ifndef FLIGHT_RECORDER_PERSIST
+#define FLIGHT_RECORDER_PERSIST 0
+#endif
+
+#define FLIGHT_READ_INTERRUPTED 1  // Tag left, or a page did not read, before pages 4-39 were in
+#define FLIGHT_READ_INVALID 2      // All pages read, no KOR record in them
+#define FLIGHT_WRITE_READOUT 3     // Readout page write failed, data is the image being written
+#define FLIGHT_WRITE_PROVISION 4   // Provisioning write, verify or lock failed, data is the message
+
+#define FLIGHT_DATA_SIZE ((39 - 4 + 1) * 4)  // Pages 4-39
+
+struct FlightRecord {
+  uint32_t sequence;   // Counts every failure since the records were cleared
+  uint32_t time;       // millis()
+  uint8_t uid[7];
+  uint8_t uidLength;
+  uint8_t reader;
+  uint8_t reason;
+  uint8_t page;        // First page that failed, 0 if not known
+  uint8_t cc[4];       // Capability container, zero if not read
+  uint16_t length;     // Valid bytes in data
+  uint8_t data[FLIGHT_DATA_SIZE];
+};
+
+void loadFlightRecorder();
+void clearFlightRecorder();
+void recordFlight(uint8_t reason, uint8_t reader, uint8_t page, const uint8_t* cc, const uint8_t* data,
+                  uint16_t length);
+
+// One line per record, oldest first:
+// FR,<sequence>,<time>,<reader>,<uid>,<reason>,<page>,<cc>,<length>,<data>
+// with uid, cc and data in hex
+void printFlightRecorder();
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <Arduino.h>
+
+#include "main.h"
+
+// Race history: a ring of sessions over a shared ring of press slots. Every
+// KOR00 in the PENDING state starts a new session; older ones stay readable
+// until their press slots are needed again.
+
+#ifndef HISTORY_SESSIONS
+#define HISTORY_SESSIONS 16
+#endif
+#ifndef HISTORY_PRESSES
+#define HISTORY_PRESSES 256   // Press slots shared by all sessions
+#endif
+#define SESSION_PRESSES 100   // Presses per session (readout payload capacity)
+
+// Same values as kor::RaceStatus
+#define SESSION_FINISHED 0
+#define SESSION_RUNNING 1
+#define SESSION_DISQUALIFIED 2  // Finish with missing or out of order controls
+
+struct RaceSession {
+  uint16_t firstPress;  // Slot of the first press in the press ring
+  uint8_t pressCount;
+  uint8_t courseLength;
+  uint8_t status;
+  uint32_t startTime;   // millis() at the start punch
+};
+
+// Start a new, empty session, evicting the oldest if the ring is full
+RaceSession* startSession(uint8_t courseLength, uint32_t startTime);
+
+// Append to the latest session. Evicts old sessions whose press slots are
+// reused; returns false when the session is full or there is none.
+bool addSessionPress(const CheckpointPress& press);
+
+uint8_t sessionCount();
+
+// 0 = latest session, 1 = the one before, ...; nullptr past the oldest
+RaceSession* historySession(uint8_t age);
+const CheckpointPress& sessionPress(const RaceSession& session, uint8_t index);
+
+// CSV over Serial, latest first
+void printHistory();
+
+#endif
@@ -6,12 +6,21 @@
 #define LOG_LEVEL_WARN 2
 #define LOG_LEVEL_ERROR 3
 
+// Messages below LOG_LEVEL are compiled out; the station profile can raise
+// the threshold further at run time (see config.h)
+#ifndef LOG_LEVEL
 #define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Also for code that logs more than one message, e.g. hex dumps: false at
+// compile time below LOG_LEVEL, so the dump is left out of the build
+#include "config.h"
+#define LOG_ENABLED(level) ((level) >= LOG_LEVEL && stationConfig.logLevel <= (level))
 
 // LOG_DEBUG
 #if (LOG_LEVEL <= LOG_LEVEL_DEBUG)
-#define LOG_DEBUG(msg, ...) Serial.print(msg, ##__VA_ARGS__)
-#define LOGLN_DEBUG(msg, ...) Serial.println(msg, ##__VA_ARGS__)
+#define LOG_DEBUG(msg, ...) do { if (LOG_ENABLED(LOG_LEVEL_DEBUG)) Serial.print(msg, ##__VA_ARGS__); } while (0)
+#define LOGLN_DEBUG(msg, ...) do { if (LOG_ENABLED(LOG_LEVEL_DEBUG)) Serial.println(msg, ##__VA_ARGS__); } while (0)
 #else
 #define LOG_DEBUG(msg, ...)
 #define LOGLN_DEBUG(msg, ...)
@@ -19,8 +28,8 @@
 
 // LOG_INFO
 #if (LOG_LEVEL <= LOG_LEVEL_INFO)
-#define LOG_INFO(msg, ...) Serial.print(msg, ##__VA_ARGS__)
-#define LOGLN_INFO(msg, ...) Serial.println(msg, ##__VA_ARGS__)
+#define LOG_INFO(msg, ...) do { if (LOG_ENABLED(LOG_LEVEL_INFO)) Serial.print(msg, ##__VA_ARGS__); } while (0)
+#define LOGLN_INFO(msg, ...) do { if (LOG_ENABLED(LOG_LEVEL_INFO)) Serial.println(msg, ##__VA_ARGS__); } while (0)
 #else
 #define LOG_INFO(msg, ...)
 #define LOGLN_INFO(msg, ...)
@@ -28,8 +37,8 @@
 
 // LOG_WARN
 #if (LOG_LEVEL <= LOG_LEVEL_WARN)
-#define LOG_WARN(msg, ...) Serial.print(msg, ##__VA_ARGS__)
-#define LOGLN_WARN(msg, ...) Serial.println(msg, ##__VA_ARGS__)
+#define LOG_WARN(msg, ...) do { if (LOG_ENABLED(LOG_LEVEL_WARN)) Serial.print(msg, ##__VA_ARGS__); } while (0)
+#define LOGLN_WARN(msg, ...) do { if (LOG_ENABLED(LOG_LEVEL_WARN)) Serial.println(msg, ##__VA_ARGS__); } while (0)
 #else
 #define LOG_WARN(msg, ...)
 #define LOGLN_WARN(msg, ...)
@@ -37,8 +46,8 @@
 
 // LOG_ERROR
 #if (LOG_LEVEL <= LOG_LEVEL_ERROR)
-#define LOG_ERROR(msg, ...) Serial.print(msg, ##__VA_ARGS__)
-#define LOGLN_ERROR(msg, ...) Serial.println(msg, ##__VA_ARGS__)
+#define LOG_ERROR(msg, ...) do { if (LOG_ENABLED(LOG_LEVEL_ERROR)) Serial.print(msg, ##__VA_ARGS__); } while (0)
+#define LOGLN_ERROR(msg, ...) do { if (LOG_ENABLED(LOG_LEVEL_ERROR)) Serial.println(msg, ##__VA_ARGS__); } while (0)
 #else
 #define LOG_ERROR(msg, ...)
 #define LOGLN_ERROR(msg, ...)
@@ -6,16 +6,21 @@
 // Checkpoint press structure
 struct CheckpointPress {
   uint8_t checkpoint;
+  uint8_t reader;      // Index of the NFC reader that saw the tap
   uint32_t timestamp;  // Relative time in milliseconds since race start
 };
 
 // Global variables
-extern CheckpointPress pressTable[100];
-extern uint8_t pressCount;
 extern uint8_t courseLength;
 
 // Function declarations
-void processReadoutTrigger();
-void processCheckpoint(uint8_t checkpointNum, uint8_t courseLen);
+void processReadoutTrigger(uint8_t reader);
+void processCheckpoint(uint8_t checkpointNum, uint8_t courseLen, uint8_t reader);
+
+// Write an older session (0 = latest) on the next readout
+bool selectReadoutSession(uint8_t age);
+
+// Rebuild the readout payload after the URL prefix changed
+void refreshReadoutPayload();
 
 #endif
\ No newline at end of file
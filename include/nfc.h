@@ -2,8 +2,53 @@
 #define NFC_H
 
 #include <Arduino.h>
+#include <Adafruit_PN532.h>
 
-bool readNfcCard();
-bool parseNdefRecord(uint8_t* data, uint16_t dataLength);
-bool writeUrlToNfc(String url);
+// Pin definitions for Wemos D1 Mini
+#define PN532_SS   (16)  // D0 - Slave Select pin for PN532
+#define PN532_SS_2 (5)   // D1 - Slave Select pin for the second PN532 (mass-start stations)
+
+// Number of PN532 readers sharing the SPI bus, each on its own chip select pin
+#ifndef NFC_READER_COUNT
+#define NFC_READER_COUNT 1
+#endif
+
+#if NFC_READER_COUNT > 2
+#error "Add slave select pins for the additional PN532 readers"
+#endif
+
+// How the readers share polling time:
+//   NFC_POLL_ROUND_ROBIN - one reader per poll tick, ticks come NFC_READER_COUNT times as often
+//   NFC_POLL_INTERLEAVED - every reader once per poll tick, back to back
+#define NFC_POLL_ROUND_ROBIN 0
+#define NFC_POLL_INTERLEAVED 1
+
+#ifndef NFC_POLL_MODE
+#define NFC_POLL_MODE NFC_POLL_INTERLEAVED
+#endif
+
+struct NfcReader {
+  Adafruit_PN532 pn532;
+  bool online;
+  uint8_t uid[7];       // Tag currently being processed
+  uint8_t uidLength;
+};
+
+extern NfcReader nfcReaders[NFC_READER_COUNT];
+
+bool initNfcReaders();
+void pollNfcReaders();
+bool readNfcCard(uint8_t reader);
+
+// Building blocks for code that handles a tag itself (provisioning, diagnostics)
+bool detectNfcTag(uint8_t reader);        // New tag in the field, UID in nfcReaders[reader]
+bool selectNfcTag(uint8_t reader);        // Any tag in the field, the tap cooldown does not apply
+void acceptNfcTap(uint8_t reader);        // Start the cooldown for the current tag
+bool readNfcPages(uint8_t reader, uint8_t page, uint8_t* buffer);  // 4 pages, 16 bytes
+bool readNfcPagesFast(uint8_t reader, uint8_t first, uint8_t last, uint8_t* buffer);  // FAST_READ, inclusive
+bool writeNfcPage(uint8_t reader, uint8_t page, const uint8_t* data);
+bool readNfcVersion(uint8_t reader, uint8_t* version);             // GET_VERSION, 8 bytes
+
+bool parseNdefRecord(uint8_t* data, uint16_t dataLength, uint8_t reader = 0);
+bool writeReadoutToNfc(uint8_t reader);
 #endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef PROVISION_H
+#define PROVISION_H
+
+#include <Arduino.h>
+
+// Provisioning mode: every new tag presented is written with the next
+// control's NDEF record, verified, optionally locked, and its UID added to
+// the manifest. A tag already in the manifest is left as it is. Started
+// from the serial console or a provisioning tag.
+//
+// A provisioning tag carries a "KORPROV" text record ("KORPROV/05",
+// "KORPROV/05L": first control, L = lock) followed by an NFC Forum external
+// record, type "kor:p", payload [check(4)]: the low 32 bits of SipHash-2-4
+// over the text, keyed with the readout MAC key as for configuration tags,
+// so a stray or forged tag cannot renumber or lock anything.
+
+#define PROVISION_OFF 0
+#define PROVISION_START 1      // KOR00/NN, followed by the manifest of the controls written so far
+#define PROVISION_CONTROLS 2   // KOR01, KOR02, ... up to the last number
+#define PROVISION_READOUT 3    // Readout trigger URL
+#define PROVISION_CONFIG 4     // KORCFG with the active station profile
+#define PROVISION_TAGS 5       // KORPROV/NN provisioning tags for this station key
+
+#define PROVISION_TEXT "KORPROV"
+#define PROVISION_RECORD_TYPE "kor:p"
+
+#define PROVISION_MANIFEST_SIZE 100
+
+void startProvisioning(uint8_t mode, uint8_t first, uint8_t last, bool lock);
+void stopProvisioning();
+bool isProvisioning();
+void provisionNfcCard(uint8_t reader);
+
+// A KORPROV text record and the record after it (`record`, `recordLength`,
+// none if it was the last one): start provisioning if the check matches,
+// the tag itself stops it again. False if the text is not KORPROV.
+bool parseProvisioningText(const uint8_t* text, uint8_t length, const uint8_t* record, uint16_t recordLength,
+                           uint8_t reader);
+
+void printProvisionManifest();
+
+#endif
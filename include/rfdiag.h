@@ -0,0 +1,48 @@
+#ifndef RFDIAG_H
+#define RFDIAG_H
+
+#include <Arduino.h>
+
+// RF link diagnostics: with a tag held on the antenna, detection, single page
+// reads, FAST_READ and the complete read of a tap are run over and over and
+// timed, to qualify tag mounts, antennas and firmware builds before an event.
+// Normal tap handling is suspended while it runs. The report of the last run
+// stays in memory until the next one starts.
+
+#define RF_DIAG_OP_DETECT 0      // InListPassiveTarget until the tag is selected
+#define RF_DIAG_OP_READ 1        // One READ, 4 pages
+#define RF_DIAG_OP_FAST_READ 2   // FAST_READ of pages 4-39
+#define RF_DIAG_OP_TAP_READ 3    // What a tap does: detect, CC, pages 4-39 page by page
+#define RF_DIAG_OPS 4
+
+#define RF_DIAG_SAMPLES 64       // Latencies kept per operation for the percentiles
+#define RF_DIAG_ATTEMPTS 3       // Tries per operation, re-selecting the tag in between
+
+struct RfDiagStats {
+  uint16_t ok;
+  uint16_t failed;               // Still failing after RF_DIAG_ATTEMPTS tries
+  uint16_t retries;
+  uint32_t slowest;              // Microseconds, over the whole run
+  uint32_t samples[RF_DIAG_SAMPLES];  // Successful attempts, microseconds, the newest replace the oldest
+};
+
+struct RfDiagReport {
+  uint8_t reader;
+  uint8_t uid[7];
+  uint8_t uidLength;
+  uint16_t cycles;
+  uint16_t noTag;                // Cycles that never found a tag
+  RfDiagStats ops[RF_DIAG_OPS];
+};
+
+#define RF_DIAG_DEFAULT_CYCLES 100
+
+void startRfDiag(uint16_t cycles, uint8_t reader);
+void stopRfDiag();                // Prints the report
+bool isRfDiagRunning();
+void runRfDiag(uint8_t reader);
+
+const RfDiagReport& rfDiagReport();
+void printRfDiagReport();
+
+#endif
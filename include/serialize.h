@@ -1,6 +1,41 @@
 #ifndef SERIALIZE_H
 #define SERIALIZE_H
 
+#include <Arduino.h>
+
+#include "main.h"
+
+// Readout URL written to the readout tag: URI code 0x04 ("https://") + prefix + payload.
+// The prefix is the station profile's (config.h); this is its default.
+#define READOUT_URI_CODE 0x04
+#define READOUT_URL_PREFIX "kor.swarm.ostuda.net/dump.html?table="
+
+// The readout NDEF message occupies pages 4-39 (NTAG213 user memory)
+#define READOUT_FIRST_PAGE 4
+#define READOUT_LAST_PAGE 39
+#define READOUT_IMAGE_SIZE ((READOUT_LAST_PAGE - READOUT_FIRST_PAGE + 1) * 4)
+
+// Station key for the readout MAC (see lib/korcodec). The default is for
+// development only; build each station with its own, e.g.
+//   -DREADOUT_MAC_KEY="{0x12,0x34,...}"
+#ifndef READOUT_MAC_KEY
+#define READOUT_MAC_KEY { 'K', 'O', 'R', '-', 'd', 'e', 'v', 'e', 'l', 'o', 'p', 'm', 'e', 'n', 't', '!' }
+#endif
+
+// Payload text followed by the MAC parameter
 String serializePressTable();
 
-#endif
\ No newline at end of file
+// The readout payload (binary, base64url and NDEF page image) is kept up to
+// date as presses are added, so a readout is a straight page write.
+void resetReadoutPayload();
+void appendReadoutPress(uint8_t courseLen, const CheckpointPress& press);
+
+const char* readoutPayloadText();
+const char* readoutMacText();  // MAC of the whole table, "" before the first press
+const uint8_t* readoutNdefImage(uint16_t* length);
+
+// Bit n set = page READOUT_FIRST_PAGE + n must be written to bring this tag up to date
+uint64_t readoutPagesToWrite(const uint8_t* uid, uint8_t uidLength);
+void markReadoutPagesWritten(const uint8_t* uid, uint8_t uidLength, uint64_t pages);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+// EEPROM (flash emulation) layout shared by everything that persists state.
+// All users call EEPROM.begin(EEPROM_SIZE), so none of them re-sizes the
+// buffer under another one.
+
+#define EEPROM_SIZE 2688
+
+#define TAG_CACHE_EEPROM_OFFSET 0
+#define TAG_CACHE_EEPROM_LIMIT 1024
+#define FLIGHT_RECORDER_EEPROM_OFFSET 1024
+#define FLIGHT_RECORDER_EEPROM_LIMIT 2560
+#define CONFIG_EEPROM_OFFSET 2560
+#define CONFIG_EEPROM_LIMIT 2688
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef TAGCACHE_H
+#define TAGCACHE_H
+
+#include <Arduino.h>
+#include "storage.h"
+
+// UID -> parsed tag cache. A control tag whose UID is known is handled from
+// the anticollision exchange alone, without reading its NDEF pages.
+
+#ifndef NFC_TAG_CACHE_SIZE
+#define NFC_TAG_CACHE_SIZE 64
+#endif
+
+// Keep the cache in flash (EEPROM emulation) across power cycles
+#ifndef NFC_TAG_CACHE_PERSIST
+#define NFC_TAG_CACHE_PERSIST 0
+#endif
+
+#define TAG_KIND_CHECKPOINT 0
+#define TAG_KIND_READOUT 1
+
+struct CachedTag {
+  uint8_t uid[7];
+  uint8_t uidLength;
+  uint8_t kind;
+  uint8_t checkpoint;
+};
+
+// Course manifest: an NFC Forum external record following the KOR00 text
+// record, type "kor:m", payload [checkpoint(1) uid(7)]*. Checkpoint 0xFF
+// marks a readout tag. The whole message has to fit in pages 4-39, which
+// leaves room for 14 tags.
+#define MANIFEST_RECORD_TYPE "kor:m"
+#define MANIFEST_READOUT 0xFF
+
+void loadTagCache();
+void clearTagCache();
+const CachedTag* findCachedTag(const uint8_t* uid, uint8_t uidLength);
+void cacheTag(const uint8_t* uid, uint8_t uidLength, uint8_t kind, uint8_t checkpoint);
+
+// A start tag without a manifest: the cache is kept across runs of the same
+// course and only emptied for a course of another length (0 = not given)
+void startTagCacheCourse(uint8_t courseLength);
+
+// Replace the cache with the manifest record at `record`, if there is one.
+// Returns the number of tags loaded.
+uint8_t loadCourseManifest(const uint8_t* record, uint16_t length, uint8_t courseLength);
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef KORCODEC_BASE64_SIMD_H
+#define KORCODEC_BASE64_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "korcodec.h"
+
+// Vectorised base64url decoding for bulk processing on the host. SSSE3 turns
+// 16 characters into 12 bytes per step, AVX2 32 into 24; the remainder goes
+// through base64UrlDecodeScalar(). Each path is compiled with a target
+// attribute and picked at run time, so the tools need no -m flags and still
+// run on CPUs without AVX2. Elsewhere (the firmware) only the scalar path
+// exists.
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define KORCODEC_X86 1
+#include <immintrin.h>
+#else
+#define KORCODEC_X86 0
+#endif
+
+namespace kor {
+
+enum class Base64Impl : uint8_t {
+  Scalar,
+  Sse,
+  Avx2
+};
+
+inline const char* base64ImplName(Base64Impl impl) {
+  switch (impl) {
+    case Base64Impl::Sse: return "sse";
+    case Base64Impl::Avx2: return "avx2";
+    default: return "scalar";
+  }
+}
+
+#if KORCODEC_X86
+
+// Character -> sextet: add a per-class offset. Any byte outside the alphabet
+// leaves a hole in the class mask.
+__attribute__((target("ssse3"))) inline bool base64UrlDecodeBlockSse(const char* in, uint8_t* out) {
+  const __m128i c = _mm_loadu_si128((const __m128i*)in);
+
+  const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('Z' + 1)));
+  const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('z' + 1)));
+  const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+  const __m128i dash = _mm_cmpeq_epi8(c, _mm_set1_epi8('-'));
+  const __m128i plus = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+  const __m128i underscore = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+  const __m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+
+  __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, dash));
+  valid = _mm_or_si128(valid, _mm_or_si128(plus, _mm_or_si128(underscore, slash)));
+  if (_mm_movemask_epi8(valid) != 0xFFFF) return false;
+
+  __m128i offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+  offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+  offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+  offset = _mm_or_si128(offset, _mm_and_si128(dash, _mm_set1_epi8(62 - '-')));
+  offset = _mm_or_si128(offset, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+  offset = _mm_or_si128(offset, _mm_and_si128(underscore, _mm_set1_epi8(63 - '_')));
+  offset = _mm_or_si128(offset, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+  const __m128i sextets = _mm_add_epi8(c, offset);
+
+  // Pairs of sextets -> 12 bits, pairs of those -> 24 bits per dword, then
+  // the three low bytes of each dword in big-endian order
+  const __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+  const __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+  const __m128i bytes = _mm_shuffle_epi8(groups, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  _mm_storeu_si128((__m128i*)out, bytes);  // 12 bytes of output, 4 bytes of slack
+  return true;
+}
+
+__attribute__((target("avx2"))) inline bool base64UrlDecodeBlockAvx2(const char* in, uint8_t* out) {
+  const __m256i c = _mm256_loadu_si256((const __m256i*)in);
+
+  const __m256i upper = _mm256_andnot_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('Z')), _mm256_cmpgt_epi8(c, _mm256_set1_epi8('A' - 1)));
+  const __m256i lower = _mm256_andnot_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('z')), _mm256_cmpgt_epi8(c, _mm256_set1_epi8('a' - 1)));
+  const __m256i digit = _mm256_andnot_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('9')), _mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)));
+  const __m256i dash = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('-'));
+  const __m256i plus = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('+'));
+  const __m256i underscore = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'));
+  const __m256i slash = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('/'));
+
+  __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, dash));
+  valid = _mm256_or_si256(valid, _mm256_or_si256(plus, _mm256_or_si256(underscore, slash)));
+  if (_mm256_movemask_epi8(valid) != -1) return false;
+
+  __m256i offset = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+  offset = _mm256_or_si256(offset, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+  offset = _mm256_or_si256(offset, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+  offset = _mm256_or_si256(offset, _mm256_and_si256(dash, _mm256_set1_epi8(62 - '-')));
+  offset = _mm256_or_si256(offset, _mm256_and_si256(plus, _mm256_set1_epi8(62 - '+')));
+  offset = _mm256_or_si256(offset, _mm256_and_si256(underscore, _mm256_set1_epi8(63 - '_')));
+  offset = _mm256_or_si256(offset, _mm256_and_si256(slash, _mm256_set1_epi8(63 - '/')));
+  const __m256i sextets = _mm256_add_epi8(c, offset);
+
+  const __m256i pairs = _mm256_maddubs_epi16(sextets, _mm256_set1_epi32(0x01400140));
+  const __m256i groups = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+  // The shuffle works per 128-bit lane: 12 bytes in each, then close the gap
+  const __m256i bytes = _mm256_shuffle_epi8(groups, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                                     2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  const __m256i packed = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+  _mm256_storeu_si256((__m256i*)out, packed);  // 24 bytes of output, 8 bytes of slack
+  return true;
+}
+
+#endif  // KORCODEC_X86
+
+inline bool base64ImplSupported(Base64Impl impl) {
+#if KORCODEC_X86
+  __builtin_cpu_init();
+  switch (impl) {
+    case Base64Impl::Avx2: return __builtin_cpu_supports("avx2");
+    case Base64Impl::Sse: return __builtin_cpu_supports("ssse3");
+    default: return true;
+  }
+#else
+  return impl == Base64Impl::Scalar;
+#endif
+}
+
+inline Base64Impl bestBase64Impl() {
+  static const Base64Impl best = base64ImplSupported(Base64Impl::Avx2) ? Base64Impl::Avx2
+                                 : base64ImplSupported(Base64Impl::Sse) ? Base64Impl::Sse
+                                                                        : Base64Impl::Scalar;
+  return best;
+}
+
+// Same contract as base64UrlDecodeScalar(): `out` holds
+// base64UrlDecodedLength(length) bytes. The vector steps store a whole
+// register, so they only run while that still fits in `out`.
+inline bool base64UrlDecode(const char* in, size_t length, uint8_t* out, Base64Impl impl = bestBase64Impl()) {
+  size_t i = 0;
+  size_t n = 0;
+#if KORCODEC_X86
+  const size_t decodedLength = base64UrlDecodedLength(length);
+  if (impl == Base64Impl::Avx2) {
+    for (; i + 32 <= length && n + 32 <= decodedLength; i += 32, n += 24) {
+      if (!base64UrlDecodeBlockAvx2(in + i, out + n)) return false;
+    }
+  }
+  if (impl == Base64Impl::Avx2 || impl == Base64Impl::Sse) {
+    for (; i + 16 <= length && n + 16 <= decodedLength; i += 16, n += 12) {
+      if (!base64UrlDecodeBlockSse(in + i, out + n)) return false;
+    }
+  }
+#endif
+  return base64UrlDecodeScalar(in + i, length - i, out + n);
+}
+
+}  // namespace kor
+
+#endif
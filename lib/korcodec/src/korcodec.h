@@ -0,0 +1,184 @@
+#ifndef KORCODEC_H
+#define KORCODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Readout payload format, shared by the firmware (src/serialize.cpp) and the
+// host tools. web/dump.html carries the only other copy, in JavaScript.
+//
+//   [1 byte course length] then per press [1 byte checkpoint][3 bytes timestamp, big-endian]
+//
+// base64url-encoded (A-Z a-z 0-9 - _) without padding. Timestamps are
+// milliseconds since the start punch, clamped to 24 bits (4.6 hours).
+//
+// The URL may carry a MAC after the payload, "&m=" + 8 base64url characters:
+// the low 48 bits of a SipHash-2-4 chain over the table, keyed per station.
+//
+//   mac = SipHash(key, [course length])
+//   mac = SipHash(key, [previous mac, 8 bytes little-endian][press, 4 bytes])   per press
+//
+// The station extends the chain as presses come in, so the readout costs
+// nothing extra.
+//
+// Only plain buffers here, so the firmware can use it; press_table.h has the
+// host-side containers and validation.
+
+namespace kor {
+
+const uint8_t START_CHECKPOINT = 0;
+const uint8_t FINISH_CHECKPOINT = 99;
+const uint8_t PRESS_SIZE = 4;
+const uint32_t MAX_TIMESTAMP = 0xFFFFFF;
+
+static const char BASE64URL_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// Write one press (PRESS_SIZE bytes)
+inline void packPress(uint8_t* out, uint8_t checkpoint, uint32_t timestamp) {
+  if (timestamp > MAX_TIMESTAMP) timestamp = MAX_TIMESTAMP;
+  out[0] = checkpoint;
+  out[1] = (timestamp >> 16) & 0xFF;
+  out[2] = (timestamp >> 8) & 0xFF;
+  out[3] = timestamp & 0xFF;
+}
+
+inline void unpackPress(const uint8_t* in, uint8_t* checkpoint, uint32_t* timestamp) {
+  *checkpoint = in[0];
+  *timestamp = ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+inline size_t base64UrlEncodedLength(size_t length) {
+  return (length * 4 + 2) / 3;
+}
+
+// Encode one group of 1-3 bytes; returns the number of characters (2-4)
+inline uint8_t base64UrlEncodeGroup(const uint8_t* in, size_t length, char* out) {
+  uint32_t block = (uint32_t)in[0] << 16;
+  if (length > 1) block |= (uint32_t)in[1] << 8;
+  if (length > 2) block |= in[2];
+
+  out[0] = BASE64URL_CHARS[(block >> 18) & 0x3F];
+  out[1] = BASE64URL_CHARS[(block >> 12) & 0x3F];
+  if (length < 2) return 2;
+  out[2] = BASE64URL_CHARS[(block >> 6) & 0x3F];
+  if (length < 3) return 3;
+  out[3] = BASE64URL_CHARS[block & 0x3F];
+  return 4;
+}
+
+// Returns the number of characters written (no terminator)
+inline size_t base64UrlEncode(const uint8_t* in, size_t length, char* out) {
+  size_t n = 0;
+  for (size_t i = 0; i < length; i += 3) {
+    n += base64UrlEncodeGroup(in + i, length - i < 3 ? length - i : 3, out + n);
+  }
+  return n;
+}
+
+// 0-63, or -1 for characters outside the alphabet. '+' and '/' (plain
+// base64) are accepted too.
+inline int8_t base64UrlValue(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '-' || c == '+') return 62;
+  if (c == '_' || c == '/') return 63;
+  return -1;
+}
+
+inline size_t base64UrlDecodedLength(size_t length) {
+  return length * 3 / 4;
+}
+
+// Decode `length` characters (no padding) into base64UrlDecodedLength(length)
+// bytes. A dangling sixth bit group is dropped, like the original decoder.
+// Returns false on characters outside the alphabet.
+inline bool base64UrlDecodeScalar(const char* in, size_t length, uint8_t* out) {
+  uint32_t block = 0;
+  uint8_t bits = 0;
+  size_t n = 0;
+  for (size_t i = 0; i < length; i++) {
+    int8_t v = base64UrlValue(in[i]);
+    if (v < 0) return false;
+    block = (block << 6) | (uint32_t)v;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out[n++] = (block >> bits) & 0xFF;
+    }
+  }
+  return true;
+}
+
+const uint8_t MAC_KEY_SIZE = 16;
+const uint8_t MAC_TEXT_LENGTH = 8;  // 48 bits
+#define KOR_MAC_PARAM "&m="
+
+inline uint64_t rotateLeft(uint64_t x, uint8_t bits) {
+  return (x << bits) | (x >> (64 - bits));
+}
+
+inline uint64_t readLittleEndian64(const uint8_t* in) {
+  uint64_t value = 0;
+  for (uint8_t i = 0; i < 8; i++) value |= (uint64_t)in[i] << (8 * i);
+  return value;
+}
+
+inline void sipRound(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) {
+  v0 += v1; v1 = rotateLeft(v1, 13); v1 ^= v0; v0 = rotateLeft(v0, 32);
+  v2 += v3; v3 = rotateLeft(v3, 16); v3 ^= v2;
+  v0 += v3; v3 = rotateLeft(v3, 21); v3 ^= v0;
+  v2 += v1; v1 = rotateLeft(v1, 17); v1 ^= v2; v2 = rotateLeft(v2, 32);
+}
+
+// SipHash-2-4 with a MAC_KEY_SIZE-byte key
+inline uint64_t sipHash24(const uint8_t* key, const uint8_t* data, size_t length) {
+  const uint64_t k0 = readLittleEndian64(key);
+  const uint64_t k1 = readLittleEndian64(key + 8);
+  uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+  uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+  uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+  uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t m = readLittleEndian64(data + i);
+    v3 ^= m;
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    v0 ^= m;
+  }
+  uint64_t last = (uint64_t)length << 56;
+  for (uint8_t j = 0; i + j < length; j++) last |= (uint64_t)data[i + j] << (8 * j);
+  v3 ^= last;
+  sipRound(v0, v1, v2, v3);
+  sipRound(v0, v1, v2, v3);
+  v0 ^= last;
+
+  v2 ^= 0xFF;
+  for (uint8_t r = 0; r < 4; r++) sipRound(v0, v1, v2, v3);
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+inline uint64_t macStart(const uint8_t* key, uint8_t courseLength) {
+  return sipHash24(key, &courseLength, 1);
+}
+
+// `press` is PRESS_SIZE bytes as packed by packPress()
+inline uint64_t macAddPress(const uint8_t* key, uint64_t mac, const uint8_t* press) {
+  uint8_t message[8 + PRESS_SIZE];
+  for (uint8_t i = 0; i < 8; i++) message[i] = (mac >> (8 * i)) & 0xFF;
+  for (uint8_t i = 0; i < PRESS_SIZE; i++) message[8 + i] = press[i];
+  return sipHash24(key, message, sizeof(message));
+}
+
+// MAC_TEXT_LENGTH characters, no terminator
+inline void macText(uint64_t mac, char* out) {
+  uint8_t bytes[6];
+  for (uint8_t i = 0; i < 6; i++) bytes[i] = (mac >> (8 * (5 - i))) & 0xFF;
+  base64UrlEncode(bytes, sizeof(bytes), out);
+}
+
+}  // namespace kor
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef PRESS_TABLE_H
+#define PRESS_TABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base64_simd.h"
+#include "korcodec.h"
+
+// Host-side press tables: decoding readout URLs (format in korcodec.h) and
+// the validation and splits web/dump.html shows.
+
+namespace kor {
+
+struct Press {
+  uint8_t checkpoint;
+  uint32_t timestamp;  // Milliseconds since race start
+};
+
+struct PressTable {
+  uint8_t courseLength = 0;
+  std::vector<Press> presses;
+};
+
+enum class RaceStatus : uint8_t {
+  Finished = 0,      // Finish reached with all controls in sequence
+  Running = 1,       // No finish punch yet
+  Disqualified = 2   // Finish reached with missing or out of order controls
+};
+
+// Per-press validation and splits, equivalent to detectOutOfOrder() and the
+// split column in dump.html
+struct Analysis {
+  std::vector<bool> outOfOrder;
+  std::vector<int32_t> splits;  // -1 for out of order presses
+  RaceStatus status = RaceStatus::Running;
+  uint32_t totalTime = 0;
+  uint8_t visited = 0;          // Distinct in-sequence controls incl. start and finish
+};
+
+// Decode base64url (padding optional). Returns false on invalid characters.
+inline bool base64UrlDecode(std::string_view in, std::vector<uint8_t>& out, Base64Impl impl = bestBase64Impl()) {
+  while (!in.empty() && in.back() == '=') in.remove_suffix(1);
+
+  out.resize(base64UrlDecodedLength(in.size()));
+  return base64UrlDecode(in.data(), in.size(), out.data(), impl);
+}
+
+inline std::string base64UrlEncode(const uint8_t* data, size_t length) {
+  std::string result(base64UrlEncodedLength(length), '\0');
+  base64UrlEncode(data, length, &result[0]);
+  return result;
+}
+
+// Same layout as the firmware's readout payload
+inline std::string encodePressTable(const PressTable& table) {
+  std::vector<uint8_t> binary(1 + table.presses.size() * PRESS_SIZE);
+  binary[0] = table.courseLength;
+  for (size_t i = 0; i < table.presses.size(); i++) {
+    packPress(&binary[1 + i * PRESS_SIZE], table.presses[i].checkpoint, table.presses[i].timestamp);
+  }
+  return base64UrlEncode(binary.data(), binary.size());
+}
+
+enum class MacStatus : uint8_t {
+  Unchecked,  // No key given
+  Missing,
+  Valid,
+  Invalid
+};
+
+inline const char* macStatusName(MacStatus status) {
+  switch (status) {
+    case MacStatus::Missing: return "missing";
+    case MacStatus::Valid: return "valid";
+    case MacStatus::Invalid: return "invalid";
+    default: return "unchecked";
+  }
+}
+
+// 32 hex digits, as given to the firmware in READOUT_MAC_KEY
+inline bool parseMacKey(std::string_view hex, uint8_t* key) {
+  if (hex.size() != MAC_KEY_SIZE * 2) return false;
+  for (size_t i = 0; i < hex.size(); i++) {
+    char c = hex[i];
+    int nibble = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+    if (nibble < 0) return false;
+    if (i % 2 == 0) key[i / 2] = nibble << 4;
+    else key[i / 2] |= nibble;
+  }
+  return true;
+}
+
+// The "&m=" parameter of a dump URL, empty if there is none
+inline std::string_view extractMacParam(std::string_view text) {
+  const std::string_view param = KOR_MAC_PARAM;
+  size_t pos = text.find(param);
+  if (pos == std::string_view::npos) return {};
+  text.remove_prefix(pos + param.size());
+  return text.substr(0, text.find_first_of("&# \t\r\n"));
+}
+
+// Replays the station's chain over the decoded payload (whole presses only)
+inline uint64_t pressTableMac(const uint8_t* key, const uint8_t* data, size_t length) {
+  if (length < 1) return 0;
+  uint64_t mac = macStart(key, data[0]);
+  for (size_t i = 1; i + PRESS_SIZE <= length; i += PRESS_SIZE) {
+    mac = macAddPress(key, mac, data + i);
+  }
+  return mac;
+}
+
+inline MacStatus verifyPressTableMac(const uint8_t* key, const uint8_t* data, size_t length, std::string_view macParam) {
+  if (!key) return MacStatus::Unchecked;
+  if (macParam.empty()) return MacStatus::Missing;
+
+  char expected[MAC_TEXT_LENGTH];
+  macText(pressTableMac(key, data, length), expected);
+  return macParam == std::string_view(expected, MAC_TEXT_LENGTH) ? MacStatus::Valid : MacStatus::Invalid;
+}
+
+// Accepts a bare payload, a "table=..." query or a full dump URL, with or
+// without the MAC parameter
+inline std::string_view extractTablePayload(std::string_view text) {
+  size_t pos = text.find("table=");
+  if (pos != std::string_view::npos) text.remove_prefix(pos + 6);
+  return text.substr(0, text.find_first_of("&# \t\r\n"));
+}
+
+inline bool parsePressTable(const uint8_t* data, size_t length, PressTable& table) {
+  table.presses.clear();
+  if (length < 1) return false;
+
+  table.courseLength = data[0];
+  table.presses.resize((length - 1) / PRESS_SIZE);
+  for (size_t i = 0; i < table.presses.size(); i++) {
+    unpackPress(data + 1 + i * PRESS_SIZE, &table.presses[i].checkpoint, &table.presses[i].timestamp);
+  }
+  return !table.presses.empty();
+}
+
+inline bool decodePressTable(std::string_view text, PressTable& table) {
+  std::vector<uint8_t> binary;
+  if (!base64UrlDecode(extractTablePayload(text), binary)) return false;
+  return parsePressTable(binary.data(), binary.size(), table);
+}
+
+// Single pass over the presses: sequence validation and splits relative to the
+// previous in-sequence press
+inline Analysis analysePressTable(const PressTable& table) {
+  Analysis result;
+  const std::vector<Press>& presses = table.presses;
+  result.outOfOrder.assign(presses.size(), false);
+  result.splits.assign(presses.size(), -1);
+  if (presses.empty()) return result;
+
+  if (presses[0].checkpoint != START_CHECKPOINT) result.outOfOrder[0] = true;
+
+  uint8_t expectedNext = 1;
+  bool hasError = false;
+  for (size_t i = 1; i < presses.size(); i++) {
+    uint8_t checkpoint = presses[i].checkpoint;
+
+    if (checkpoint == FINISH_CHECKPOINT) {
+      if (hasError || expectedNext <= table.courseLength) result.outOfOrder[i] = true;
+      break;  // Finish ends the sequence
+    }
+    if (checkpoint == START_CHECKPOINT || checkpoint > table.courseLength) {
+      result.outOfOrder[i] = true;
+      continue;
+    }
+    if (checkpoint == expectedNext) {
+      hasError = false;
+      expectedNext++;
+    } else {
+      result.outOfOrder[i] = true;
+      hasError = true;
+    }
+  }
+
+  uint32_t previousValid = 0;
+  bool seen[100] = {false};
+  for (size_t i = 0; i < presses.size(); i++) {
+    if (result.outOfOrder[i]) continue;
+    result.splits[i] = (int32_t)(presses[i].timestamp - previousValid);
+    previousValid = presses[i].timestamp;
+    uint8_t checkpoint = presses[i].checkpoint;
+    if (checkpoint < 100 && !seen[checkpoint]) {
+      seen[checkpoint] = true;
+      result.visited++;
+    }
+  }
+
+  const Press& last = presses.back();
+  result.totalTime = last.timestamp;
+  if (last.checkpoint == FINISH_CHECKPOINT) {
+    result.status = result.outOfOrder.back() ? RaceStatus::Disqualified : RaceStatus::Finished;
+  }
+  return result;
+}
+
+inline const char* raceStatusName(RaceStatus status) {
+  switch (status) {
+    case RaceStatus::Finished: return "finished";
+    case RaceStatus::Disqualified: return "disqualified";
+    default: return "running";
+  }
+}
+
+}  // namespace kor
+
+#endif
@@ -0,0 +1,259 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <korcodec.h>
+#include "config.h"
+#include "flightrec.h"
+#include "logging.h"
+#include "melodies.h"
+#include "nfc.h"
+#include "serialize.h"
+
+#include "collector.h"
+
+// Pages 4-39 hold about 100 characters of payload; anything longer is not a
+// readout image
+const uint8_t COLLECT_MAX_BINARY = 96;
+const uint8_t COLLECT_MAX_TEXT = (COLLECT_MAX_BINARY + 2) / 3 * 4;
+const uint8_t MAC_BYTES = 6;
+const uint16_t COLLECT_RETAP_TONE = 150;
+
+const uint8_t RUN_FLAG_MAC = 0x01;        // The tag carried a MAC
+const uint8_t RUN_FLAG_MAC_VALID = 0x02;  // ... and it matches this station's key
+
+// Table record on flash: [length][flags][mac(6)] then `length` payload bytes
+struct RunHeader {
+  uint8_t length;
+  uint8_t flags;
+  uint8_t mac[MAC_BYTES];
+};
+
+static const uint8_t stationKey[kor::MAC_KEY_SIZE] = READOUT_MAC_KEY;
+
+static bool collecting = false;
+static bool mounted = false;
+static uint64_t* runKeys = nullptr;  // COLLECT_MAX_RUNS, on the heap only while collecting
+static uint16_t runCount = 0;
+static uint8_t pages[(READOUT_LAST_PAGE - READOUT_FIRST_PAGE + 1) * 4];
+
+// Deduplication key: a hash of the payload, with the lowest bit saying
+// whether its MAC checked out, so a copy with a bad MAC collected first
+// does not turn the genuine readout away
+static uint64_t runKey(const uint8_t* binary, uint8_t length, uint8_t flags) {
+  uint64_t hash = kor::sipHash24(stationKey, binary, length) & ~1ULL;
+  return flags & RUN_FLAG_MAC_VALID ? hash | 1 : hash;
+}
+
+static bool mountTable() {
+  if (!mounted) mounted = LittleFS.begin();
+  if (!mounted) LOGLN_ERROR(F("Cannot mount the flash file system"));
+  return mounted;
+}
+
+// Runs in the table on flash, with their keys if `keys` is given
+static uint16_t scanTable(uint64_t* keys) {
+  if (!mountTable()) return 0;
+  File file = LittleFS.open(COLLECT_FILE, "r");
+  if (!file) return 0;
+
+  uint16_t count = 0;
+  RunHeader header;
+  uint8_t binary[COLLECT_MAX_BINARY];
+  while (count < COLLECT_MAX_RUNS && file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+         header.length <= COLLECT_MAX_BINARY && file.read(binary, header.length) == header.length) {
+    if (keys) keys[count] = runKey(binary, header.length, header.flags);
+    count++;
+  }
+  file.close();
+  return count;
+}
+
+void startCollecting() {
+  if (collecting) return;
+  runKeys = (uint64_t*)malloc(COLLECT_MAX_RUNS * sizeof(uint64_t));
+  if (!runKeys) {
+    LOGLN_ERROR(F("Not enough memory to collect"));
+    playMelody(ERROR_MELODY, ERROR_MELODY_LENGTH);
+    return;
+  }
+  runCount = scanTable(runKeys);
+  collecting = true;
+  LOG_INFO(F("Collecting readout tags, "));
+  LOG_INFO(runCount);
+  LOGLN_INFO(F(" runs so far"));
+  playMelody(READOUT_START_MELODY, READOUT_START_MELODY_LENGTH);
+}
+
+void stopCollecting() {
+  if (!collecting) return;
+  collecting = false;
+  free(runKeys);
+  runKeys = nullptr;
+  LOG_INFO(F("Collecting stopped, "));
+  LOG_INFO(runCount);
+  LOGLN_INFO(F(" runs"));
+  playMelody(READOUT_END_MELODY, READOUT_END_MELODY_LENGTH);
+}
+
+bool isCollecting() {
+  return collecting;
+}
+
+uint16_t collectedRunCount() {
+  return collecting ? runCount : scanTable(nullptr);
+}
+
+// Text of the URI record of a readout image: [03][len] [D1][01][payloadLen]['U'] [uriCode][uri...]
+static const char* readUri(const uint8_t* data, uint16_t length, uint8_t* uriLength) {
+  uint16_t i = 0;
+  while (i < length && data[i] == 0x00) i++;  // NULL TLVs
+  if (i + 7 > length || data[i] != 0x03 || data[i + 2] != 0xD1 || data[i + 3] != 0x01 || data[i + 5] != 'U') {
+    return nullptr;
+  }
+  uint8_t payloadLength = data[i + 4];
+  if (payloadLength < 1 || i + 6 + payloadLength > length) return nullptr;
+  *uriLength = payloadLength - 1;
+  return (const char*)data + i + 7;
+}
+
+// Value of the query parameter `name` ("table=") up to the next '&'
+static const char* findParam(const char* uri, uint8_t uriLength, const char* name, uint8_t* valueLength) {
+  uint8_t nameLength = strlen(name);
+  for (uint8_t i = 1; i + nameLength <= uriLength; i++) {
+    if ((uri[i - 1] == '?' || uri[i - 1] == '&') && memcmp(uri + i, name, nameLength) == 0) {
+      const char* value = uri + i + nameLength;
+      uint8_t n = 0;
+      while (i + nameLength + n < uriLength && value[n] != '&') n++;
+      *valueLength = n;
+      return value;
+    }
+  }
+  return nullptr;
+}
+
+static bool isKnownRun(uint64_t key) {
+  for (uint16_t i = 0; i < runCount; i++) {
+    if (runKeys[i] == key) return true;
+  }
+  return false;
+}
+
+static bool appendRun(const RunHeader& header, const uint8_t* binary) {
+  File file = LittleFS.open(COLLECT_FILE, "a");
+  if (!file) return false;
+  bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+            file.write(binary, header.length) == header.length;
+  file.close();
+  return ok;
+}
+
+void collectNfcCard(uint8_t reader) {
+  if (!detectNfcTag(reader)) {
+    return;
+  }
+
+  // One FAST_READ per 12 pages instead of a READ per page keeps the tag on
+  // the antenna for a fraction of the time
+  if (!readNfcPagesFast(reader, READOUT_FIRST_PAGE, READOUT_LAST_PAGE, pages)) {
+    LOGLN_WARN(F("Tag left mid-read, tap again"));
+    tone(BUZZER_PIN, ERROR_MELODY[0].frequency, COLLECT_RETAP_TONE);
+    return;
+  }
+  acceptNfcTap(reader);
+
+  uint8_t uriLength = 0;
+  uint8_t textLength = 0;
+  uint8_t macLength = 0;
+  const char* uri = readUri(pages, sizeof(pages), &uriLength);
+  const char* text = uri ? findParam(uri, uriLength, "table=", &textLength) : nullptr;
+  const char* macText = uri ? findParam(uri, uriLength, "m=", &macLength) : nullptr;
+
+  RunHeader header;
+  uint8_t binary[COLLECT_MAX_BINARY];
+  header.length = text && textLength <= COLLECT_MAX_TEXT ? kor::base64UrlDecodedLength(textLength) : 0;
+  if (header.length < 1 || (header.length - 1) % kor::PRESS_SIZE != 0 ||
+      !kor::base64UrlDecodeScalar(text, textLength, binary)) {
+    LOGLN_WARN(F("Not a readout tag"));
+    recordFlight(FLIGHT_READ_INVALID, reader, 0, nullptr, pages, sizeof(pages));
+    playMelody(ERROR_MELODY, ERROR_MELODY_LENGTH);
+    return;
+  }
+
+  // The MAC is kept as it was on the tag; the flag only says whether this
+  // station's key confirms it
+  header.flags = 0;
+  memset(header.mac, 0, sizeof(header.mac));
+  if (macText && macLength == kor::MAC_TEXT_LENGTH && kor::base64UrlDecodeScalar(macText, macLength, header.mac)) {
+    uint64_t mac = kor::macStart(stationKey, binary[0]);
+    for (uint8_t i = 1; i < header.length; i += kor::PRESS_SIZE) {
+      mac = kor::macAddPress(stationKey, mac, binary + i);
+    }
+    char expected[kor::MAC_TEXT_LENGTH];
+    kor::macText(mac, expected);
+    header.flags = RUN_FLAG_MAC;
+    if (memcmp(expected, macText, sizeof(expected)) == 0) header.flags |= RUN_FLAG_MAC_VALID;
+  }
+
+  uint64_t key = runKey(binary, header.length, header.flags);
+  if (isKnownRun(key)) {
+    LOGLN_INFO(F("Run already collected"));
+    playSuccessTone();
+    return;
+  }
+  if (runCount >= COLLECT_MAX_RUNS) {
+    LOGLN_ERROR(F("Run table full, dump and clear it"));
+    playMelody(ERROR_MELODY, ERROR_MELODY_LENGTH);
+    return;
+  }
+
+  if (!appendRun(header, binary)) {
+    LOGLN_ERROR(F("Failed to store the run"));
+    playMelody(ERROR_MELODY, ERROR_MELODY_LENGTH);
+    return;
+  }
+  runKeys[runCount++] = key;
+
+  LOG_INFO(F("Collected run "));
+  LOG_INFO(runCount);
+  LOG_INFO(F(": "));
+  LOG_INFO((header.length - 1) / kor::PRESS_SIZE);
+  LOG_INFO(F(" presses, MAC "));
+  LOGLN_INFO(header.flags & RUN_FLAG_MAC_VALID ? F("valid") : header.flags & RUN_FLAG_MAC ? F("INVALID") : F("missing"));
+  if (header.flags & RUN_FLAG_MAC_VALID) {
+    playSuccessTone();
+  } else {
+    playMelody(MISS_MELODY, MISS_MELODY_LENGTH);
+  }
+}
+
+void printCollectedRuns() {
+  Serial.print(F("# collected "));
+  Serial.print(collectedRunCount());
+  Serial.println(F(" runs"));
+
+  File file = LittleFS.open(COLLECT_FILE, "r");
+  RunHeader header;
+  uint8_t binary[COLLECT_MAX_BINARY];
+  char text[COLLECT_MAX_TEXT + 1];
+  while (file && file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+         header.length <= COLLECT_MAX_BINARY && file.read(binary, header.length) == header.length) {
+    text[kor::base64UrlEncode(binary, header.length, text)] = '\0';
+    Serial.print(F("https://"));
+    Serial.print(stationConfig.readoutPrefix);
+    Serial.print(text);
+    if (header.flags & RUN_FLAG_MAC) {
+      text[kor::base64UrlEncode(header.mac, sizeof(header.mac), text)] = '\0';
+      Serial.print(F(KOR_MAC_PARAM));
+      Serial.print(text);
+    }
+    Serial.println();
+  }
+  if (file) file.close();
+  Serial.println(F("# end"));
+}
+
+void clearCollectedRuns() {
+  if (!mountTable()) return;
+  LittleFS.remove(COLLECT_FILE);
+  runCount = 0;
+  LOGLN_INFO(F("Collected runs cleared"));
+}
@@ -0,0 +1,196 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <korcodec.h>
+#include "logging.h"
+#include "main.h"
+#include "nfc.h"
+#include "serialize.h"
+
+#include "config.h"
+
+#if NFC_POLL_MODE == NFC_POLL_ROUND_ROBIN
+const uint16_t DEFAULT_POLL_INTERVAL = 500 / NFC_READER_COUNT;  // Each reader is checked every 500ms
+#else
+const uint16_t DEFAULT_POLL_INTERVAL = 500;
+#endif
+
+// EEPROM layout: ['K']['G'] then the profile and its check, as on the tag
+const uint16_t CONFIG_EEPROM_SIZE = 2 + sizeof(StationConfig) + CONFIG_CHECK_SIZE;
+static_assert(CONFIG_EEPROM_OFFSET + CONFIG_EEPROM_SIZE <= CONFIG_EEPROM_LIMIT, "Profile does not fit its EEPROM area");
+static_assert(sizeof(READOUT_URL_PREFIX) <= CONFIG_PREFIX_SIZE, "Default readout prefix too long");
+
+static const uint8_t checkKey[kor::MAC_KEY_SIZE] = READOUT_MAC_KEY;
+
+static const StationConfig DEFAULT_CONFIG = {
+  CONFIG_VERSION, DEFAULT_POLL_INTERVAL, 100, 5000, LOG_LEVEL, READOUT_LAST_PAGE, READOUT_URL_PREFIX
+};
+
+StationConfig stationConfig = DEFAULT_CONFIG;
+
+static uint32_t profileCheck(const StationConfig& profile) {
+  return (uint32_t)kor::sipHash24(checkKey, (const uint8_t*)&profile, sizeof(profile));
+}
+
+static bool isValidPrefix(const char* prefix) {
+  uint8_t length = strnlen(prefix, CONFIG_PREFIX_SIZE);
+  if (length == 0 || length == CONFIG_PREFIX_SIZE) return false;
+  for (uint8_t i = 0; i < length; i++) {
+    if (prefix[i] <= ' ' || prefix[i] > '~') return false;
+  }
+  return true;
+}
+
+static bool isValid(const StationConfig& profile) {
+  return profile.version == CONFIG_VERSION &&
+         profile.pollInterval >= 50 && profile.pollInterval <= 5000 &&
+         profile.loopDelay <= 250 &&
+         profile.logLevel <= LOG_LEVEL_ERROR &&
+         profile.lastReadPage >= CONFIG_MIN_READ_PAGE && profile.lastReadPage <= READOUT_LAST_PAGE &&
+         isValidPrefix(profile.readoutPrefix);
+}
+
+// Take a validated profile into use; the readout image depends on the prefix
+static void useConfig(const StationConfig& profile) {
+  bool prefixChanged = strcmp(profile.readoutPrefix, stationConfig.readoutPrefix) != 0;
+  stationConfig = profile;
+#if LOG_LEVEL > LOG_LEVEL_DEBUG
+  if (stationConfig.logLevel < LOG_LEVEL) stationConfig.logLevel = LOG_LEVEL;
+#endif
+  if (prefixChanged) refreshReadoutPayload();
+}
+
+static void saveConfig() {
+  uint32_t check = profileCheck(stationConfig);
+  EEPROM.write(CONFIG_EEPROM_OFFSET, 'K');
+  EEPROM.write(CONFIG_EEPROM_OFFSET + 1, 'G');
+  EEPROM.put(CONFIG_EEPROM_OFFSET + 2, stationConfig);
+  EEPROM.put(CONFIG_EEPROM_OFFSET + 2 + sizeof(StationConfig), check);
+  EEPROM.commit();
+}
+
+void loadConfig() {
+  StationConfig profile;
+  uint32_t check;
+
+  EEPROM.begin(EEPROM_SIZE);
+  if (EEPROM.read(CONFIG_EEPROM_OFFSET) != 'K' || EEPROM.read(CONFIG_EEPROM_OFFSET + 1) != 'G') {
+    return;
+  }
+  EEPROM.get(CONFIG_EEPROM_OFFSET + 2, profile);
+  EEPROM.get(CONFIG_EEPROM_OFFSET + 2 + sizeof(StationConfig), check);
+  if (check != profileCheck(profile) || !isValid(profile)) {
+    LOGLN_WARN(F("Stored profile invalid, using defaults"));
+    return;
+  }
+  useConfig(profile);
+  LOGLN_INFO(F("Loaded station profile"));
+}
+
+void resetConfig() {
+  useConfig(DEFAULT_CONFIG);
+  saveConfig();
+}
+
+void printConfig() {
+  Serial.print(F("profile v"));
+  Serial.println(stationConfig.version);
+  Serial.print(F("  poll      "));
+  Serial.print(stationConfig.pollInterval);
+  Serial.println(F(" ms"));
+  Serial.print(F("  delay     "));
+  Serial.print(stationConfig.loopDelay);
+  Serial.println(F(" ms"));
+  Serial.print(F("  cooldown  "));
+  Serial.print(stationConfig.cooldown);
+  Serial.println(F(" ms"));
+  Serial.print(F("  log       "));
+  Serial.println(stationConfig.logLevel);
+  Serial.print(F("  lastpage  "));
+  Serial.println(stationConfig.lastReadPage);
+  Serial.print(F("  prefix    https://"));
+  Serial.println(stationConfig.readoutPrefix);
+}
+
+bool setConfigValue(const char* name, const char* value) {
+  StationConfig profile = stationConfig;
+  long number = atol(value);
+  bool isByte = number >= 0 && number <= 0xFF;
+  bool isWord = number >= 0 && number <= 0xFFFF;
+
+  if (strcmp(name, "poll") == 0 && isWord) {
+    profile.pollInterval = number;
+  } else if (strcmp(name, "delay") == 0 && isByte) {
+    profile.loopDelay = number;
+  } else if (strcmp(name, "cooldown") == 0 && isWord) {
+    profile.cooldown = number;
+  } else if (strcmp(name, "log") == 0 && isByte) {
+    profile.logLevel = number;
+  } else if (strcmp(name, "lastpage") == 0 && isByte) {
+    profile.lastReadPage = number;
+  } else if (strcmp(name, "prefix") == 0 && strlen(value) < CONFIG_PREFIX_SIZE) {
+    memset(profile.readoutPrefix, 0, sizeof(profile.readoutPrefix));
+    strcpy(profile.readoutPrefix, value);
+  } else {
+    return false;
+  }
+
+  if (!isValid(profile)) return false;
+  useConfig(profile);
+  saveConfig();
+  return true;
+}
+
+bool applyConfigRecord(const uint8_t* record, uint16_t length) {
+  const uint8_t typeLength = sizeof(CONFIG_RECORD_TYPE) - 1;
+  const uint8_t payloadLength = sizeof(StationConfig) + CONFIG_CHECK_SIZE;
+
+  // Short external record: [flags][type length][payload length][type][payload]
+  if (length < 3 + typeLength + payloadLength || (record[0] & 0x1F) != 0x14 || record[1] != typeLength ||
+      record[2] != payloadLength || memcmp(record + 3, CONFIG_RECORD_TYPE, typeLength) != 0) {
+    LOGLN_WARN(F("No station profile on the configuration tag"));
+    return false;
+  }
+
+  StationConfig profile;
+  uint32_t check;
+  memcpy(&profile, record + 3 + typeLength, sizeof(profile));
+  memcpy(&check, record + 3 + typeLength + sizeof(profile), sizeof(check));
+  if (profile.version != CONFIG_VERSION) {
+    LOGLN_WARN(F("Station profile version not supported"));
+    return false;
+  }
+  if (check != profileCheck(profile)) {
+    LOGLN_WARN(F("Station profile not made for this station key"));
+    return false;
+  }
+  if (!isValid(profile)) {
+    LOGLN_WARN(F("Station profile out of range"));
+    return false;
+  }
+
+  useConfig(profile);
+  saveConfig();
+  LOGLN_INFO(F("Station profile applied"));
+  return true;
+}
+
+uint8_t readoutHostLength() {
+  const char* slash = strchr(stationConfig.readoutPrefix, '/');
+  return slash ? slash - stationConfig.readoutPrefix + 1 : strlen(stationConfig.readoutPrefix);
+}
+
+uint16_t buildConfigRecord(uint8_t* record) {
+  const uint8_t typeLength = sizeof(CONFIG_RECORD_TYPE) - 1;
+  uint32_t check = profileCheck(stationConfig);
+  uint16_t n = 0;
+
+  record[n++] = 0x54;  // TNF=4 (External), ME=1, SR=1
+  record[n++] = typeLength;
+  record[n++] = sizeof(StationConfig) + CONFIG_CHECK_SIZE;
+  memcpy(record + n, CONFIG_RECORD_TYPE, typeLength);
+  n += typeLength;
+  memcpy(record + n, &stationConfig, sizeof(StationConfig));
+  n += sizeof(StationConfig);
+  memcpy(record + n, &check, sizeof(check));
+  return n + sizeof(check);
+}
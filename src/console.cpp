@@ -0,0 +1,180 @@
+#include <Arduino.h>
+#include "collector.h"
+#include "config.h"
+#include "flightrec.h"
+#include "history.h"
+#include "main.h"
+#include "nfc.h"
+#include "provision.h"
+#include "rfdiag.h"
+#include "tagcache.h"
+
+#include "console.h"
+
+static char line[64];
+static uint8_t lineLength = 0;
+
+static void printHelp() {
+  Serial.println(F("Commands:"));
+  Serial.println(F("  prov controls <first> [last] [lock]  write KOR<first>..KOR<last>"));
+  Serial.println(F("  prov start <course length> [lock]    write KOR00/NN with the manifest so far"));
+  Serial.println(F("  prov readout [lock]                  write readout trigger tags"));
+  Serial.println(F("  prov config [lock]                   write KORCFG tags with the active profile"));
+  Serial.println(F("  prov tags <first> [lock]             write KORPROV tags, lock = they lock the controls"));
+  Serial.println(F("  prov stop                            leave provisioning mode"));
+  Serial.println(F("  manifest                             print the UIDs of the provisioned tags"));
+  Serial.println(F("  history                              list the stored race sessions"));
+  Serial.println(F("  readout <age>                        write session <age> (0 = latest) on the next readout"));
+  Serial.println(F("  config                               print the active station profile"));
+  Serial.println(F("  config <name> <value> | defaults     change and save the profile"));
+  Serial.println(F("  tags clear                           forget the known control and readout tags"));
+  Serial.println(F("  flightrec [clear]                    dump (or clear) the failed tag reads and writes"));
+  Serial.println(F("  rfdiag [cycles] [reader]             time reads of a tag held on the antenna"));
+  Serial.println(F("  rfdiag stop | report                 stop early, print the last report"));
+  Serial.println(F("  collect start | stop                 read back readout tags at the finish tent"));
+  Serial.println(F("  collect dump | clear                 print (or clear) the collected runs as dump URLs"));
+}
+
+static bool isLockArgument(const char* argument) {
+  return argument && strcmp(argument, "lock") == 0;
+}
+
+// A whole decimal argument within [min, max]; atoi() would wrap 300 to 44
+static bool parseNumber(const char* argument, long min, long max, long* value) {
+  if (!argument) return false;
+  char* end;
+  *value = strtol(argument, &end, 10);
+  return end != argument && *end == '\0' && *value >= min && *value <= max;
+}
+
+static void runProvisionCommand(char* arguments) {
+  char* what = strtok(arguments, " ");
+  char* first = strtok(nullptr, " ");
+  char* second = strtok(nullptr, " ");
+  char* third = strtok(nullptr, " ");
+  long from;
+  long to = 99;
+
+  if (what && strcmp(what, "stop") == 0) {
+    stopProvisioning();
+  } else if (what && strcmp(what, "readout") == 0) {
+    startProvisioning(PROVISION_READOUT, 0, 0, isLockArgument(first));
+  } else if (what && strcmp(what, "config") == 0) {
+    startProvisioning(PROVISION_CONFIG, 0, 0, isLockArgument(first));
+  } else if (what && strcmp(what, "tags") == 0 && parseNumber(first, 1, 98, &from)) {
+    startProvisioning(PROVISION_TAGS, from, 0, isLockArgument(second));
+  } else if (what && strcmp(what, "start") == 0 && parseNumber(first, 1, 98, &from)) {
+    startProvisioning(PROVISION_START, from, 0, isLockArgument(second));
+  } else if (what && strcmp(what, "controls") == 0 && parseNumber(first, 1, 99, &from)) {
+    bool lock = isLockArgument(second) || isLockArgument(third);
+    if (second && !isLockArgument(second) && !parseNumber(second, 1, 99, &to)) {
+      printHelp();
+      return;
+    }
+    if (to < from) {
+      Serial.println(F("Last control before the first"));
+      return;
+    }
+    startProvisioning(PROVISION_CONTROLS, from, to, lock);
+  } else {
+    printHelp();
+  }
+}
+
+static void runRfDiagCommand(char* arguments) {
+  char* first = strtok(arguments, " ");
+  char* second = strtok(nullptr, " ");
+
+  if (first && strcmp(first, "stop") == 0) {
+    stopRfDiag();
+  } else if (first && strcmp(first, "report") == 0) {
+    printRfDiagReport();
+  } else {
+    long cycles = RF_DIAG_DEFAULT_CYCLES;
+    long reader = 1;
+    if ((first && !parseNumber(first, 1, 0xFFFF, &cycles)) ||
+        (second && !parseNumber(second, 1, NFC_READER_COUNT, &reader))) {
+      printHelp();
+      return;
+    }
+    if (!nfcReaders[reader - 1].online) {
+      Serial.println(F("Reader offline"));
+      return;
+    }
+    startRfDiag(cycles, reader - 1);
+  }
+}
+
+static void runCollectCommand(const char* argument) {
+  if (strcmp(argument, "start") == 0) {
+    startCollecting();
+  } else if (strcmp(argument, "stop") == 0) {
+    stopCollecting();
+  } else if (strcmp(argument, "dump") == 0) {
+    printCollectedRuns();
+  } else if (strcmp(argument, "clear") == 0) {
+    clearCollectedRuns();
+  } else {
+    printHelp();
+  }
+}
+
+static void runConfigCommand(char* arguments) {
+  char* name = strtok(arguments, " ");
+  char* value = strtok(nullptr, " ");
+
+  if (name && strcmp(name, "defaults") == 0) {
+    resetConfig();
+  } else if (name && (!value || !setConfigValue(name, value))) {
+    Serial.println(F("Unknown setting or value out of range"));
+    return;
+  }
+  printConfig();
+}
+
+static void runCommand(char* command) {
+  if (strncmp(command, "prov", 4) == 0 && (command[4] == ' ' || command[4] == '\0')) {
+    runProvisionCommand(command + 4);
+  } else if (strcmp(command, "manifest") == 0) {
+    printProvisionManifest();
+  } else if (strncmp(command, "rfdiag", 6) == 0 && (command[6] == ' ' || command[6] == '\0')) {
+    runRfDiagCommand(command + 6);
+  } else if (strncmp(command, "config", 6) == 0 && (command[6] == ' ' || command[6] == '\0')) {
+    runConfigCommand(command + 6);
+  } else if (strncmp(command, "collect ", 8) == 0) {
+    runCollectCommand(command + 8);
+  } else if (strcmp(command, "tags clear") == 0) {
+    clearTagCache();
+    Serial.println(F("Known tags cleared"));
+  } else if (strcmp(command, "flightrec") == 0) {
+    printFlightRecorder();
+  } else if (strcmp(command, "flightrec clear") == 0) {
+    clearFlightRecorder();
+  } else if (strcmp(command, "history") == 0) {
+    printHistory();
+  } else if (strncmp(command, "readout ", 8) == 0) {
+    long age;
+    if (!parseNumber(command + 8, 0, 0xFF, &age)) {
+      printHelp();
+    } else if (!selectReadoutSession(age)) {
+      Serial.println(F("No such session"));
+    }
+  } else {
+    printHelp();
+  }
+}
+
+void pollConsole() {
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c == '\r' || c == '\n') {
+      if (lineLength > 0) {
+        line[lineLength] = '\0';
+        lineLength = 0;
+        runCommand(line);
+      }
+    } else if (lineLength < sizeof(line) - 1) {
+      line[lineLength++] = c;
+    }
+  }
+}
@@ -0,0 +1,145 @@
+#include <Arduino.h>
+#include "logging.h"
+#include "nfc.h"
+
+#include "flightrec.h"
+
+#if FLIGHT_RECORDER_PERSIST
+#include <EEPROM.h>
+#endif
+
+static FlightRecord records[FLIGHT_RECORDER_SIZE];
+static uint8_t recordCount = 0;
+static uint8_t nextRecord = 0;   // Slot the next failure goes to, the oldest once full
+static uint32_t sequence = 0;
+
+static const char* const REASON_NAMES[] = { "", "interrupted", "invalid", "write_readout", "write_provision" };
+
+#if FLIGHT_RECORDER_PERSIST
+// EEPROM layout: ['K']['F'][count][next][sequence(4)] then the record slots
+const uint16_t FLIGHT_HEADER_SIZE = 8;
+static_assert(FLIGHT_RECORDER_EEPROM_OFFSET + FLIGHT_HEADER_SIZE + sizeof(records) <= FLIGHT_RECORDER_EEPROM_LIMIT,
+              "Flight recorder does not fit its EEPROM area");
+
+static void saveFlightHeader() {
+  EEPROM.write(FLIGHT_RECORDER_EEPROM_OFFSET, 'K');
+  EEPROM.write(FLIGHT_RECORDER_EEPROM_OFFSET + 1, 'F');
+  EEPROM.write(FLIGHT_RECORDER_EEPROM_OFFSET + 2, recordCount);
+  EEPROM.write(FLIGHT_RECORDER_EEPROM_OFFSET + 3, nextRecord);
+  EEPROM.put(FLIGHT_RECORDER_EEPROM_OFFSET + 4, sequence);
+}
+
+// Only the new slot and the header change
+static void saveFlightRecord(uint8_t slot) {
+  EEPROM.put(FLIGHT_RECORDER_EEPROM_OFFSET + FLIGHT_HEADER_SIZE + slot * sizeof(FlightRecord), records[slot]);
+  saveFlightHeader();
+  EEPROM.commit();
+}
+#else
+static void saveFlightRecord(uint8_t slot) {}
+#endif
+
+void loadFlightRecorder() {
+  recordCount = 0;
+  nextRecord = 0;
+  sequence = 0;
+#if FLIGHT_RECORDER_PERSIST
+  EEPROM.begin(EEPROM_SIZE);
+  if (EEPROM.read(FLIGHT_RECORDER_EEPROM_OFFSET) != 'K' || EEPROM.read(FLIGHT_RECORDER_EEPROM_OFFSET + 1) != 'F') {
+    return;
+  }
+  uint8_t count = EEPROM.read(FLIGHT_RECORDER_EEPROM_OFFSET + 2);
+  uint8_t next = EEPROM.read(FLIGHT_RECORDER_EEPROM_OFFSET + 3);
+  if (count > FLIGHT_RECORDER_SIZE || next >= FLIGHT_RECORDER_SIZE) {
+    return;  // Written by a build with a different FLIGHT_RECORDER_SIZE
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    EEPROM.get(FLIGHT_RECORDER_EEPROM_OFFSET + FLIGHT_HEADER_SIZE + i * sizeof(FlightRecord), records[i]);
+  }
+  EEPROM.get(FLIGHT_RECORDER_EEPROM_OFFSET + 4, sequence);
+  recordCount = count;
+  nextRecord = next;
+  if (recordCount > 0) {
+    LOG_INFO(F("Flight recorder: "));
+    LOG_INFO(recordCount);
+    LOGLN_INFO(F(" failed tag operations kept"));
+  }
+#endif
+}
+
+void clearFlightRecorder() {
+  recordCount = 0;
+  nextRecord = 0;
+  sequence = 0;
+#if FLIGHT_RECORDER_PERSIST
+  saveFlightHeader();
+  EEPROM.commit();
+#endif
+}
+
+void recordFlight(uint8_t reason, uint8_t reader, uint8_t page, const uint8_t* cc, const uint8_t* data,
+                  uint16_t length) {
+  uint8_t slot = nextRecord;
+  FlightRecord& record = records[slot];
+  nextRecord = (nextRecord + 1) % FLIGHT_RECORDER_SIZE;
+  if (recordCount < FLIGHT_RECORDER_SIZE) recordCount++;
+
+  if (length > FLIGHT_DATA_SIZE) length = FLIGHT_DATA_SIZE;
+  record.sequence = ++sequence;
+  record.time = millis();
+  memcpy(record.uid, nfcReaders[reader].uid, sizeof(record.uid));
+  record.uidLength = nfcReaders[reader].uidLength;
+  record.reader = reader;
+  record.reason = reason;
+  record.page = page;
+  if (cc) {
+    memcpy(record.cc, cc, sizeof(record.cc));
+  } else {
+    memset(record.cc, 0, sizeof(record.cc));
+  }
+  record.length = length;
+  memcpy(record.data, data, length);
+
+  saveFlightRecord(slot);
+}
+
+static void printHex(const uint8_t* bytes, uint16_t length) {
+  for (uint16_t i = 0; i < length; i++) {
+    if (bytes[i] < 0x10) Serial.print('0');
+    Serial.print(bytes[i], HEX);
+  }
+}
+
+void printFlightRecorder() {
+  Serial.print(F("# flight recorder: "));
+  Serial.print(recordCount);
+  Serial.print(F(" of "));
+  Serial.print(sequence);
+  Serial.println(F(" failures kept"));
+
+  uint8_t slot = (nextRecord + FLIGHT_RECORDER_SIZE - recordCount) % FLIGHT_RECORDER_SIZE;
+  for (uint8_t i = 0; i < recordCount; i++) {
+    const FlightRecord& record = records[slot];
+    slot = (slot + 1) % FLIGHT_RECORDER_SIZE;
+
+    Serial.print(F("FR,"));
+    Serial.print(record.sequence);
+    Serial.print(',');
+    Serial.print(record.time);
+    Serial.print(',');
+    Serial.print(record.reader + 1);
+    Serial.print(',');
+    printHex(record.uid, record.uidLength);
+    Serial.print(',');
+    Serial.print(record.reason < sizeof(REASON_NAMES) / sizeof(REASON_NAMES[0]) ? REASON_NAMES[record.reason] : "");
+    Serial.print(',');
+    Serial.print(record.page);
+    Serial.print(',');
+    printHex(record.cc, sizeof(record.cc));
+    Serial.print(',');
+    Serial.print(record.length);
+    Serial.print(',');
+    printHex(record.data, record.length);
+    Serial.println();
+  }
+}
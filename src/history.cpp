@@ -0,0 +1,81 @@
+#include <Arduino.h>
+
+#include "history.h"
+
+static_assert(SESSION_PRESSES < HISTORY_PRESSES, "the latest session must never be evicted");
+
+static RaceSession sessions[HISTORY_SESSIONS];
+static uint8_t newestSession = HISTORY_SESSIONS - 1;
+static uint8_t storedSessions = 0;
+
+static CheckpointPress presses[HISTORY_PRESSES];
+static uint16_t nextPress = 0;     // Next free slot
+static uint16_t storedPresses = 0; // Slots held by the stored sessions
+
+static void evictOldestSession() {
+  storedPresses -= historySession(storedSessions - 1)->pressCount;
+  storedSessions--;
+}
+
+RaceSession* startSession(uint8_t courseLength, uint32_t startTime) {
+  if (storedSessions == HISTORY_SESSIONS) {
+    evictOldestSession();
+  }
+  newestSession = (newestSession + 1) % HISTORY_SESSIONS;
+  storedSessions++;
+
+  RaceSession& session = sessions[newestSession];
+  session.firstPress = nextPress;
+  session.pressCount = 0;
+  session.courseLength = courseLength;
+  session.status = SESSION_RUNNING;
+  session.startTime = startTime;
+  return &session;
+}
+
+bool addSessionPress(const CheckpointPress& press) {
+  if (storedSessions == 0) return false;
+  RaceSession& session = sessions[newestSession];
+  if (session.pressCount >= SESSION_PRESSES) return false;
+
+  // The slot may still belong to the oldest session: drop it as a whole
+  while (storedPresses == HISTORY_PRESSES) {
+    evictOldestSession();
+  }
+
+  presses[nextPress] = press;
+  nextPress = (nextPress + 1) % HISTORY_PRESSES;
+  storedPresses++;
+  session.pressCount++;
+  return true;
+}
+
+uint8_t sessionCount() {
+  return storedSessions;
+}
+
+RaceSession* historySession(uint8_t age) {
+  if (age >= storedSessions) return nullptr;
+  return &sessions[(newestSession + HISTORY_SESSIONS - age) % HISTORY_SESSIONS];
+}
+
+const CheckpointPress& sessionPress(const RaceSession& session, uint8_t index) {
+  return presses[(session.firstPress + index) % HISTORY_PRESSES];
+}
+
+void printHistory() {
+  Serial.println(F("age,start,course,presses,status"));
+  for (uint8_t age = 0; age < storedSessions; age++) {
+    const RaceSession* session = historySession(age);
+    Serial.print(age);
+    Serial.print(F(","));
+    Serial.print(session->startTime);
+    Serial.print(F(","));
+    Serial.print(session->courseLength);
+    Serial.print(F(","));
+    Serial.print(session->pressCount);
+    Serial.print(F(","));
+    Serial.println(session->status == SESSION_FINISHED ? F("finished")
+                   : session->status == SESSION_DISQUALIFIED ? F("disqualified") : F("running"));
+  }
+}
@@ -5,6 +5,10 @@
 #include <Wire.h>
 #include <Adafruit_PN532.h>
 
+#include "collector.h"
+#include "config.h"
+#include "console.h"
+#include "history.h"
 #include "melodies.h"
 #include "nfc.h"
 #include "serialize.h"
@@ -17,12 +21,14 @@ extern HardwareSerial Serial;
 extern SPIClass SPI;
 extern TwoWire Wire;
 
-// Pin definitions for Wemos D1 Mini
-#define PN532_SS   (16)  // D0 - Slave Select pin for PN532
-
 // Use hardware SPI communication for PN532
 // Hardware SPI uses fixed pins: SCK=D5, MOSI=D7, MISO=D6
-Adafruit_PN532 nfc(PN532_SS);
+NfcReader nfcReaders[NFC_READER_COUNT] = {
+  { Adafruit_PN532(PN532_SS), false, {0}, 0 },
+#if NFC_READER_COUNT > 1
+  { Adafruit_PN532(PN532_SS_2), false, {0}, 0 },
+#endif
+};
 
 // System states
 enum RaceState {
@@ -32,21 +38,24 @@ enum RaceState {
 
 // Global variables
 RaceState currentState = RACE_PENDING;
-CheckpointPress pressTable[100];  // Max 100 checkpoint presses
-uint8_t pressCount = 0;
 uint32_t lastNfcCheck = 0;
 uint32_t raceStartTime = 0;  // Timestamp in milliseconds when KOR00 was scanned (race start)
 uint8_t nextExpectedCheckpoint = 0;  // Track next expected checkpoint for sequence validation
 uint8_t courseLength = 7;
-const uint32_t NFC_CHECK_INTERVAL = 500; // Check NFC every 500ms
+
+// Session currently in the readout payload (0 = latest)
+uint8_t readoutAge = 0;
+bool readoutAgeSelected = false;  // Chosen on the console for the next readout
 
 // Function declarations
-void clearPressTable();
-void addCheckpointPress(uint8_t checkpoint, bool isStart);
+void startNewSession();
+void showSessionInReadout(uint8_t age);
+void addCheckpointPress(uint8_t checkpoint, bool isStart, uint8_t reader);
 void printPressTable();
 
 void setup() {
   Serial.begin(115200);
+  loadConfig();  // Poll timing, cooldown and log level for everything below
   LOGLN_INFO(F("KOR Orienteering Checkpoint Tracker"));
 
   // Initialize buzzer pin
@@ -56,11 +65,8 @@ void setup() {
   // Play startup tone
   playMelody(INIT_MELODY, INIT_MELODY_LENGTH);
 
-  // Initialize PN532
-  nfc.begin();
-
-  uint32_t versiondata = nfc.getFirmwareVersion();
-  if (!versiondata) {
+  // Initialize PN532 readers
+  if (!initNfcReaders()) {
     LOGLN_ERROR(F("Didn't find PN532 board"));
     delay(500);
     playMelody(ERROR_MELODY, ERROR_MELODY_LENGTH);
@@ -71,48 +77,43 @@ void setup() {
     while (1) delay(1000); // halt
   }
 
-  LOG_INFO(F("Found chip PN5"));
-  LOGLN_INFO((versiondata>>24) & 0xFF, HEX);
-  LOG_INFO(F("Firmware ver. "));
-  LOG_INFO((versiondata>>16) & 0xFF, DEC);
-  LOG_INFO('.');
-  LOGLN_INFO((versiondata>>8) & 0xFF, DEC);
-
-  // Configure for reading NTAG213/215/216
-  nfc.SAMConfig();
-
+#if COLLECTOR_MODE
+  startCollecting();
+#else
   LOGLN_INFO(F("System ready - PENDING state"));
   LOGLN_INFO(F("Present KOR00 to start tracking"));
+#endif
 }
 
 void loop() {
   uint32_t currentTime = millis();
 
+  pollConsole();
+
   // Check for NFC card periodically
-  if (currentTime - lastNfcCheck >= NFC_CHECK_INTERVAL) {
+  if (currentTime - lastNfcCheck >= stationConfig.pollInterval) {
     lastNfcCheck = currentTime;
-    readNfcCard();
+    pollNfcReaders();
   }
 
-  delay(100); // Small delay to prevent excessive CPU usage
+  delay(stationConfig.loopDelay); // Small delay to prevent excessive CPU usage
 }
 
-void processCheckpoint(uint8_t checkpointNum, uint8_t courseLen) {
+void processCheckpoint(uint8_t checkpointNum, uint8_t courseLen, uint8_t reader) {
   bool validCheckpoint = false;
   bool correctSequence = false;
 
   if (currentState == RACE_PENDING) {
     if (checkpointNum == 0) {
-      LOGLN_INFO(F("Start checkpoint detected - clearing table and switching to RUNNING"));
-      clearPressTable();  // Clear everything first
+      LOGLN_INFO(F("Start checkpoint detected - new session, switching to RUNNING"));
       if (courseLen > 0) {
         courseLength = courseLen;
       }
       raceStartTime = millis();  // Set race start time baseline in milliseconds
-      nextExpectedCheckpoint = 1;  // After start, expect checkpoint 1
+      startNewSession();  // Earlier sessions stay in the history
       LOG_DEBUG(F("Race start time set to: "));
       LOGLN_DEBUG(raceStartTime);
-      addCheckpointPress(0, true);
+      addCheckpointPress(0, true, reader);
       currentState = RACE_RUNNING;
       validCheckpoint = true;
       correctSequence = true;
@@ -126,7 +127,7 @@ void processCheckpoint(uint8_t checkpointNum, uint8_t courseLen) {
     LOGLN_INFO(checkpointNum);
 
     // Always add to press table regardless of sequence
-    addCheckpointPress(checkpointNum, false);
+    addCheckpointPress(checkpointNum, false, reader);
     validCheckpoint = true;
 
     // Check sequence correctness
@@ -142,6 +143,7 @@ void processCheckpoint(uint8_t checkpointNum, uint8_t courseLen) {
         // Check if all required controls have been visited in correct sequence
         if (nextExpectedCheckpoint == courseLength + 1) {
           LOGLN_INFO(F("All controls visited in sequence - course complete!"));
+          historySession(0)->status = SESSION_FINISHED;
           playMelody(FINISH_MELODY, FINISH_MELODY_LENGTH);
         } else {
           LOG_WARN(F("Finish with missing controls:\n\tLast visited: KOR"));
@@ -151,6 +153,7 @@ void processCheckpoint(uint8_t checkpointNum, uint8_t courseLen) {
           LOG_WARN(F("\tShould be: KOR"));
           if ((courseLength) < 10) LOG_WARN(F("0"));
           LOGLN_WARN(courseLength);
+          historySession(0)->status = SESSION_DISQUALIFIED;
           playLament();
         }
 
@@ -184,48 +187,95 @@ void processCheckpoint(uint8_t checkpointNum, uint8_t courseLen) {
   }
 }
 
-void processReadoutTrigger() {
+void processReadoutTrigger(uint8_t reader) {
   LOGLN_DEBUG(F("Processing readout trigger"));
 
-  String serializedTable = serializePressTable();
-  String dumpUrl = "https://kor.swarm.ostuda.net/dump.html?table=" + serializedTable;
-
-  LOG_INFO(F("Generated dump URL:"));
-  LOGLN_INFO(dumpUrl);
+  // Always the latest session, so a runner who taps again gets their own
+  // result; an older one only when chosen on the console ("readout <age>")
+  uint8_t age = 0;
+  if (readoutAgeSelected) {
+    age = readoutAge;
+    readoutAgeSelected = false;
+  }
+  if (age != readoutAge) {
+    showSessionInReadout(age);
+  }
 
-  playMelody(READOUT_START_MELODY, READOUT_START_MELODY_LENGTH);
+  // The payload and its NDEF image are already up to date, start writing at
+  // once and give the start cue without blocking
+  tone(BUZZER_PIN, READOUT_START_MELODY[0].frequency, READOUT_START_MELODY[0].duration);
 
-  if (writeUrlToNfc(dumpUrl)) {
-    LOGLN_INFO(F("Successfully wrote dump URL to NFC card"));
+  if (writeReadoutToNfc(reader)) {
+    LOG_INFO(F("Successfully wrote dump URL to NFC card, session "));
+    LOG_INFO(readoutAge + 1);
+    LOG_INFO(F(" of "));
+    LOGLN_INFO(sessionCount());
     playMelody(READOUT_END_MELODY, READOUT_END_MELODY_LENGTH);
   } else {
     LOGLN_WARN(F("Failed to write dump URL to NFC card"));
     playMelody(ERROR_MELODY, ERROR_MELODY_LENGTH);
   }
+
+  LOG_INFO(F("Generated dump URL:"));
+  LOG_INFO(F("https://"));
+  LOG_INFO(stationConfig.readoutPrefix);
+  LOGLN_INFO(serializePressTable());
 }
 
-void clearPressTable() {
-  pressCount = 0;
-  memset(pressTable, 0, sizeof(pressTable));
-  nextExpectedCheckpoint = 0;  // Reset expected checkpoint when clearing table
+// O(1): the new session starts at the next free press slot
+void startNewSession() {
+  startSession(courseLength, raceStartTime);
+  nextExpectedCheckpoint = 1;  // After start, expect checkpoint 1
+  resetReadoutPayload();
+  readoutAge = 0;
 }
 
-void addCheckpointPress(uint8_t checkpoint, bool isStart) {
-  if (pressCount < 100) {
-    pressTable[pressCount].checkpoint = checkpoint;
+// Rebuild the readout payload from an older (or the latest) session
+void showSessionInReadout(uint8_t age) {
+  const RaceSession* session = historySession(age);
+  resetReadoutPayload();
+  readoutAge = age;
+  if (!session) return;
+  for (uint8_t i = 0; i < session->pressCount; i++) {
+    appendReadoutPress(session->courseLength, sessionPress(*session, i));
+  }
+}
 
-    // Store relative timestamp (milliseconds since race start)
-    if (raceStartTime > 0 && !isStart) {
-      pressTable[pressCount].timestamp = millis() - raceStartTime;
-    } else {
-      pressTable[pressCount].timestamp = 0;  // Race hasn't started yet
-    }
+void refreshReadoutPayload() {
+  showSessionInReadout(readoutAge);
+}
+
+bool selectReadoutSession(uint8_t age) {
+  if (age >= sessionCount()) return false;
+  showSessionInReadout(age);
+  readoutAgeSelected = true;
+  return true;
+}
+
+void addCheckpointPress(uint8_t checkpoint, bool isStart, uint8_t reader) {
+  CheckpointPress press;
+  press.checkpoint = checkpoint;
+  press.reader = reader;
 
-    pressCount++;
+  // Store relative timestamp (milliseconds since race start)
+  if (raceStartTime > 0 && !isStart) {
+    press.timestamp = millis() - raceStartTime;
+  } else {
+    press.timestamp = 0;  // Race hasn't started yet
+  }
+
+  if (!addSessionPress(press)) return;
+  if (readoutAge == 0) {
+    appendReadoutPress(courseLength, press);
+  } else {
+    showSessionInReadout(0);
   }
 }
 
 void printPressTable() {
+  const RaceSession* session = historySession(0);
+  uint8_t pressCount = session ? session->pressCount : 0;
+
   LOGLN_INFO(F("=== Current Press Table ==="));
   LOG_INFO(F("State: "));
   LOGLN_INFO(currentState == RACE_PENDING ? F("PENDING") : F("RUNNING"));
@@ -239,13 +289,14 @@ void printPressTable() {
   LOGLN_INFO(pressCount);
 
   for (uint8_t i = 0; i < pressCount; i++) {
+    const CheckpointPress& press = sessionPress(*session, i);
     LOG_INFO(F("  KOR"));
-    if (pressTable[i].checkpoint < 10) LOG_INFO(F("0"));
-    LOG_INFO(pressTable[i].checkpoint);
+    if (press.checkpoint < 10) LOG_INFO(F("0"));
+    LOG_INFO(press.checkpoint);
     LOG_INFO(F(" at +"));
 
     // Display time in seconds.milliseconds format for readability
-    uint32_t ms = pressTable[i].timestamp;
+    uint32_t ms = press.timestamp;
     uint32_t seconds = ms / 1000;
     uint32_t remainingMs = ms % 1000;
 
@@ -254,6 +305,12 @@ void printPressTable() {
     if (remainingMs < 100) LOG_INFO(F("0"));
     if (remainingMs < 10) LOG_INFO(F("0"));
     LOG_INFO(remainingMs);
-    LOGLN_INFO(F("s"));
+    LOG_INFO(F("s"));
+    if (NFC_READER_COUNT > 1) {
+      LOG_INFO(F(" (reader "));
+      LOG_INFO(press.reader + 1);
+      LOG_INFO(F(")"));
+    }
+    LOGLN_INFO();
   }
 }
@@ -1,27 +1,294 @@
 #include <Arduino.h>
 #include <Adafruit_PN532.h>
+#include "collector.h"
+#include "config.h"
+#include "flightrec.h"
 #include "logging.h"
 #include "melodies.h"
 #include "main.h"
+#include "serialize.h"
+#include "tagcache.h"
+#include "provision.h"
+#include "rfdiag.h"
 
 #include "nfc.h"
 
-extern Adafruit_PN532 nfc;
+// Detection must give up quickly so one idle reader does not starve the others
+const uint16_t NFC_DETECT_TIMEOUT = 50;        // ms to wait for a tag per poll
+const uint8_t NFC_ACTIVATION_RETRIES = 0x10;   // PN532 InListPassiveTarget retries
+const uint32_t NFC_RESUME_TTL = 10000;         // Pages of an interrupted read are kept for 10s
+const uint16_t NFC_RETAP_TONE = 150;           // Short cue: tag left mid-read, tap again
+const uint16_t NFC_READ_SIZE = (39 - 4 + 1) * 4;  // Pages 4-39 (NTAG213 user memory), the most a tap reads
+const uint8_t NFC_FAST_READ_PAGES = 12;        // Per FAST_READ, fits the library's 64-byte frame buffer
+
+// Debounce state shared by all readers, so a tag seen by both antennas counts once
+static uint8_t lastUid[7];
+static uint8_t lastUidLength = 0;
+static uint32_t lastTapTime = 0;
+
+// Pages of a read the tag left in the middle of, continued on its next tap
+static uint8_t partialUid[7];
+static uint8_t partialUidLength = 0;
+static uint8_t partialCc[4];
+static uint8_t partialData[NFC_READ_SIZE];
+static uint16_t partialLength = 0;
+static uint32_t partialTime = 0;
+
+bool initNfcReaders() {
+  bool anyOnline = false;
+
+  loadTagCache();
+  loadFlightRecorder();
+
+  for (uint8_t r = 0; r < NFC_READER_COUNT; r++) {
+    Adafruit_PN532& pn532 = nfcReaders[r].pn532;
+    pn532.begin();
+
+    uint32_t versiondata = pn532.getFirmwareVersion();
+    if (!versiondata) {
+      LOG_WARN(F("Reader "));
+      LOG_WARN(r + 1);
+      LOGLN_WARN(F(": PN532 not found"));
+      nfcReaders[r].online = false;
+      continue;
+    }
+
+    LOG_INFO(F("Reader "));
+    LOG_INFO(r + 1);
+    LOG_INFO(F(": found chip PN5"));
+    LOGLN_INFO((versiondata>>24) & 0xFF, HEX);
+    LOG_INFO(F("Firmware ver. "));
+    LOG_INFO((versiondata>>16) & 0xFF, DEC);
+    LOG_INFO('.');
+    LOGLN_INFO((versiondata>>8) & 0xFF, DEC);
+
+    // Configure for reading NTAG213/215/216
+    pn532.SAMConfig();
+    pn532.setPassiveActivationRetries(NFC_ACTIVATION_RETRIES);
+
+    nfcReaders[r].online = true;
+    anyOnline = true;
+  }
+
+  return anyOnline;
+}
+
+static void pollReader(uint8_t reader) {
+  if (isRfDiagRunning()) {
+    runRfDiag(reader);
+  } else if (isCollecting()) {
+    collectNfcCard(reader);
+  } else if (isProvisioning()) {
+    provisionNfcCard(reader);
+  } else {
+    readNfcCard(reader);
+  }
+}
+
+void pollNfcReaders() {
+#if NFC_POLL_MODE == NFC_POLL_ROUND_ROBIN
+  static uint8_t nextReader = 0;
+
+  for (uint8_t attempts = 0; attempts < NFC_READER_COUNT; attempts++) {
+    uint8_t r = nextReader;
+    nextReader = (nextReader + 1) % NFC_READER_COUNT;
+    if (nfcReaders[r].online) {
+      pollReader(r);
+      return;
+    }
+  }
+#else
+  for (uint8_t r = 0; r < NFC_READER_COUNT; r++) {
+    if (nfcReaders[r].online) {
+      pollReader(r);
+    }
+  }
+#endif
+}
 
+// True if this UID was tapped less than the profile's cooldown ago. Seeing it again
+// extends the cooldown, so a tag left on the antenna is not read repeatedly.
+static bool isDebounced(uint8_t* uid, uint8_t uidLength) {
+  if (uidLength != lastUidLength || memcmp(uid, lastUid, uidLength) != 0) {
+    return false;
+  }
+  if (millis() - lastTapTime >= stationConfig.cooldown) {
+    return false;
+  }
+  lastTapTime = millis();
+  return true;
+}
+
+static void rememberTap(uint8_t* uid, uint8_t uidLength) {
+  memcpy(lastUid, uid, uidLength);
+  lastUidLength = uidLength;
+  lastTapTime = millis();
+}
+
+static void savePartialRead(uint8_t* uid, uint8_t uidLength, uint8_t* cc, uint8_t* data, uint16_t length) {
+  memcpy(partialUid, uid, uidLength);
+  partialUidLength = uidLength;
+  memcpy(partialCc, cc, 4);
+  memcpy(partialData, data, length);
+  partialLength = length;
+  partialTime = millis();
+}
+
+// Copy the pages kept for this tag into `data` and return their length. The
+// capability container is the same on every tag of a model, so the first
+// and the last kept pages are read again: a tag rewritten in between (by a
+// phone, or provisioned anew) is read from the start.
+static uint16_t resumePartialRead(uint8_t reader, uint8_t* cc, uint8_t* data) {
+  uint8_t* uid = nfcReaders[reader].uid;
+  uint8_t uidLength = nfcReaders[reader].uidLength;
+  if (partialLength == 0 || uidLength != partialUidLength || memcmp(uid, partialUid, uidLength) != 0) {
+    return 0;
+  }
 
-bool readNfcCard() {
+  uint16_t length = partialLength;
+  partialLength = 0;
+  if (millis() - partialTime >= NFC_RESUME_TTL || memcmp(cc, partialCc, 4) != 0) {
+    return 0;
+  }
+
+  uint8_t pages[16];
+  uint8_t firstLength = length < sizeof(pages) ? length : sizeof(pages);
+  if (!readNfcPages(reader, 4, pages) || memcmp(pages, partialData, firstLength) != 0) {
+    return 0;
+  }
+  if (length > sizeof(pages) && (!nfcReaders[reader].pn532.ntag2xx_ReadPage(4 + length / 4 - 1, pages) ||
+                                 memcmp(pages, partialData + length - 4, 4) != 0)) {
+    return 0;
+  }
+
+  memcpy(data, partialData, length);
+  return length;
+}
+
+bool detectNfcTag(uint8_t reader) {
   uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };
   uint8_t uidLength;
 
   // Check for NTAG213/215/216
-  if (nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength)) {
-    LOGLN_INFO(F("NFC card detected"));
+  if (!nfcReaders[reader].pn532.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, NFC_DETECT_TIMEOUT)) {
+    return false;
+  }
+  if (isDebounced(uid, uidLength)) {
+    return false;
+  }
+  memcpy(nfcReaders[reader].uid, uid, uidLength);
+  nfcReaders[reader].uidLength = uidLength;
+  return true;
+}
+
+bool selectNfcTag(uint8_t reader) {
+  uint8_t uidLength;
+  if (!nfcReaders[reader].pn532.readPassiveTargetID(PN532_MIFARE_ISO14443A, nfcReaders[reader].uid, &uidLength,
+                                                     NFC_DETECT_TIMEOUT)) {
+    return false;
+  }
+  nfcReaders[reader].uidLength = uidLength;
+  return true;
+}
+
+void acceptNfcTap(uint8_t reader) {
+  rememberTap(nfcReaders[reader].uid, nfcReaders[reader].uidLength);
+}
+
+bool readNfcPages(uint8_t reader, uint8_t page, uint8_t* buffer) {
+  uint8_t command[] = { 0x30, page };  // NTAG READ
+  uint8_t length = 16;
+  return nfcReaders[reader].pn532.inDataExchange(command, sizeof(command), buffer, &length) && length == 16;
+}
+
+bool readNfcPagesFast(uint8_t reader, uint8_t first, uint8_t last, uint8_t* buffer) {
+  for (uint16_t page = first; page <= last; page += NFC_FAST_READ_PAGES) {
+    uint8_t end = page + NFC_FAST_READ_PAGES - 1 < last ? page + NFC_FAST_READ_PAGES - 1 : last;
+    uint8_t command[] = { 0x3A, (uint8_t)page, end };  // NTAG FAST_READ
+    uint8_t expected = (end - page + 1) * 4;
+    uint8_t length = expected;
+    if (!nfcReaders[reader].pn532.inDataExchange(command, sizeof(command), buffer, &length) || length != expected) {
+      return false;
+    }
+    buffer += expected;
+  }
+  return true;
+}
+
+bool writeNfcPage(uint8_t reader, uint8_t page, const uint8_t* data) {
+  // Unlike ntag2xx_WritePage(), inDataExchange() fails when the tag NAKs or leaves
+  uint8_t command[] = { 0xA2, page, data[0], data[1], data[2], data[3] };  // NTAG WRITE
+  uint8_t response[4];
+  uint8_t length = sizeof(response);
+  return nfcReaders[reader].pn532.inDataExchange(command, sizeof(command), response, &length);
+}
+
+bool readNfcVersion(uint8_t reader, uint8_t* version) {
+  uint8_t command[] = { 0x60 };  // NTAG GET_VERSION
+  uint8_t length = 8;
+  return nfcReaders[reader].pn532.inDataExchange(command, sizeof(command), version, &length) && length == 8;
+}
+
+// End of the NDEF message TLV in the user memory read so far (`length`
+// bytes from page 4), or 0 while its header has not been read yet
+static uint16_t ndefMessageEnd(const uint8_t* data, uint16_t length) {
+  uint16_t i = 0;
+  while (i < length) {
+    if (data[i] == 0x00) {  // NULL TLV
+      i++;
+      continue;
+    }
+    if (data[i] == 0xFE) return i + 1;  // Terminator, no message
+    if (i + 1 >= length) return 0;
+    if (data[i + 1] == 0xFF) return NFC_READ_SIZE;  // 3-byte length, more than NTAG213 holds
+    if (data[i] == 0x03) return i + 2 + data[i + 1];
+    i += 2 + data[i + 1];  // Lock and memory control TLVs
+  }
+  return 0;
+}
+
+// Bytes a tap has to read: the profile's lastReadPage is only a floor
+static uint16_t tapReadSize(const uint8_t* data, uint16_t bytesRead) {
+  uint16_t size = (stationConfig.lastReadPage - 3) * 4;
+  uint16_t messageEnd = ndefMessageEnd(data, bytesRead);
+  if (messageEnd == 0) messageEnd = bytesRead + 4;
+  if (messageEnd > size) size = messageEnd;
+  return size < NFC_READ_SIZE ? size : NFC_READ_SIZE;
+}
+
+bool readNfcCard(uint8_t reader) {
+  Adafruit_PN532& nfc = nfcReaders[reader].pn532;
+
+  if (detectNfcTag(reader)) {
+    uint8_t* uid = nfcReaders[reader].uid;
+    uint8_t uidLength = nfcReaders[reader].uidLength;
+
+    LOG_INFO(F("NFC card detected on reader "));
+    LOGLN_INFO(reader + 1);
+
+    // A tag read before is handled from its UID alone
+    const CachedTag* known = findCachedTag(uid, uidLength);
+    if (known) {
+      uint8_t kind = known->kind;
+      uint8_t checkpoint = known->checkpoint;
+      rememberTap(uid, uidLength);
+      if (kind == TAG_KIND_READOUT) {
+        LOGLN_INFO(F("Known readout tag"));
+        processReadoutTrigger(reader);
+      } else {
+        LOG_INFO(F("Known tag: KOR"));
+        if (checkpoint < 10) LOG_INFO(F("0"));
+        LOGLN_INFO(checkpoint);
+        processCheckpoint(checkpoint, 0, reader);
+      }
+      return true;
+    }
 
     // Log the UID for debugging
     LOG_DEBUG(F("UID Length: "));
     LOG_DEBUG(uidLength, DEC);
     LOG_DEBUG(F(" bytes, UID: "));
-    if (LOG_LEVEL <= LOG_LEVEL_DEBUG) {
+    if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
       for (uint8_t i = 0; i < uidLength; i++) {
         if (uid[i] < 0x10) LOG_DEBUG(F("0"));
         LOG_DEBUG(uid[i], HEX);
@@ -31,19 +298,30 @@ bool readNfcCard() {
     LOGLN_DEBUG();
 
     // Read NDEF data from the card
-    uint8_t data[144];
+    uint8_t data[NFC_READ_SIZE];
 
     // Try to read NDEF record from page 4 onwards (NTAG213 NDEF starts at page 4)
     bool success = false;
 
-    // Read the full user memory area (pages 4-39 for NTAG213)
-    uint16_t bytesRead = 0;
-    for (uint8_t page = 4; page <= 39 && bytesRead < sizeof(data); page++) {
+    // Capability container, checked before continuing an interrupted read
+    uint8_t cc[4];
+    bool haveCc = nfc.ntag2xx_ReadPage(3, cc);
+
+    uint16_t bytesRead = haveCc ? resumePartialRead(reader, cc, data) : 0;
+    if (bytesRead > 0) {
+      LOG_INFO(F("Resuming read at page "));
+      LOGLN_INFO(4 + bytesRead / 4);
+    }
+
+    // Read at least up to the profile's last page, and on to the end of the
+    // NDEF message so longer records (KORCFG, manifests) always parse
+    uint16_t readSize = tapReadSize(data, bytesRead);
+    for (uint8_t page = 4 + bytesRead / 4; haveCc && bytesRead < readSize; page++) {
       if (nfc.ntag2xx_ReadPage(page, data + bytesRead)) {
         LOG_DEBUG(F("Read page "));
         LOG_DEBUG(page);
         LOG_DEBUG(F(": "));
-        if (LOG_LEVEL <= LOG_LEVEL_DEBUG) {
+        if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
           for (uint8_t i = 0; i < 4; i++) {
             if (data[bytesRead + i] < 0x10) LOG_DEBUG(F("0"));
             LOG_DEBUG(data[bytesRead + i], HEX);
@@ -52,6 +330,7 @@ bool readNfcCard() {
         }
         LOGLN_DEBUG();
         bytesRead += 4;
+        readSize = tapReadSize(data, bytesRead);
       } else {
         LOG_DEBUG(F("Failed to read page "));
         LOGLN_DEBUG(page);
@@ -63,7 +342,7 @@ bool readNfcCard() {
     LOGLN_DEBUG(bytesRead);
 
     if (bytesRead > 0) {
-      if (LOG_LEVEL <= LOG_LEVEL_DEBUG) {
+      if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
         Serial.println(F("Raw data hex dump:"));
         for (uint16_t i = 0; i < bytesRead; i++) {
           if (i % 16 == 0) {
@@ -94,14 +373,24 @@ bool readNfcCard() {
         Serial.println();
       }
 
-      success = parseNdefRecord(data, bytesRead);
+      success = parseNdefRecord(data, bytesRead, reader);
     }
 
-    if (!success) {
+    if (!success && bytesRead < readSize) {
+      // The tag left: keep what was read and ask for another tap without blocking
+      if (haveCc && bytesRead > 0) {
+        savePartialRead(uid, uidLength, cc, data, bytesRead);
+      }
+      recordFlight(FLIGHT_READ_INTERRUPTED, reader, haveCc ? 4 + bytesRead / 4 : 3, haveCc ? cc : nullptr, data,
+                   bytesRead);
+      LOGLN_WARN(F("Tag left mid-read, tap again"));
+      tone(BUZZER_PIN, ERROR_MELODY[0].frequency, NFC_RETAP_TONE);
+    } else if (!success) {
+      recordFlight(FLIGHT_READ_INVALID, reader, 0, cc, data, bytesRead);
       LOGLN_WARN(F("No valid KOR data found"));
       playMelody(ERROR_MELODY, ERROR_MELODY_LENGTH);
     } else {
-      delay(5000); // Cooldown period before allowing next read
+      rememberTap(uid, uidLength); // Cooldown period before allowing the same tag again
     }
 
     return success;
@@ -110,7 +399,7 @@ bool readNfcCard() {
   return false;
 }
 
-bool parseNdefRecord(uint8_t* data, uint16_t dataLength) {
+bool parseNdefRecord(uint8_t* data, uint16_t dataLength, uint8_t reader) {
   // Look for NDEF record structure
   // Simple parser for text records and URL records
 
@@ -130,7 +419,7 @@ bool parseNdefRecord(uint8_t* data, uint16_t dataLength) {
         // NDEF record starts at i + 2
         uint16_t recordStart = i + 2;
 
-        if (LOG_LEVEL <= LOG_LEVEL_DEBUG) {
+        if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
           Serial.print(F("Checking record at position "));
           Serial.print(recordStart);
           Serial.print(F(": TNF=0x"));
@@ -152,9 +441,9 @@ bool parseNdefRecord(uint8_t* data, uint16_t dataLength) {
           Serial.println();
         }
 
-        // Look for TNF=1 (Well Known), Type=T (Text)
+        // Look for TNF=1 (Well Known), Type=T (Text); ME is clear when a course manifest follows
         if (recordStart + 3 < dataLength &&
-            data[recordStart] == 0xD1 &&
+            (data[recordStart] | 0x40) == 0xD1 &&
             data[recordStart + 1] == 0x01 &&
             data[recordStart + 3] == 'T') {
           LOGLN_DEBUG(F("Found valid text record!"));
@@ -171,7 +460,7 @@ bool parseNdefRecord(uint8_t* data, uint16_t dataLength) {
           LOGLN_DEBUG(textStart);
 
           if (textStart + 5 <= dataLength) {
-            if (LOG_LEVEL <= LOG_LEVEL_DEBUG) {
+            if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
               Serial.print(F("Text content: "));
               for (uint8_t j = 0; j < 8 && textStart + j < dataLength; j++) {
                 char c = (char)data[textStart + j];
@@ -189,6 +478,24 @@ bool parseNdefRecord(uint8_t* data, uint16_t dataLength) {
             if (data[textStart] == 'K' && data[textStart + 1] == 'O' && data[textStart + 2] == 'R') {
               LOGLN_DEBUG(F("Found KOR prefix!"));
 
+              // Provisioning and configuration tags: a checked record follows the text record
+              uint16_t textEnd = recordStart + 4 + data[recordStart + 2];
+              if (textEnd > dataLength) textEnd = dataLength;
+              uint16_t messageEnd = i + 2 + recordLength;
+              bool recordFollows = !(data[recordStart] & 0x40) && textEnd < messageEnd;
+              if (parseProvisioningText(data + textStart, textEnd - textStart, recordFollows ? data + textEnd : nullptr,
+                                        recordFollows ? messageEnd - textEnd : 0, reader)) {
+                return true;
+              }
+
+              const uint8_t configLength = sizeof(CONFIG_TEXT) - 1;
+              if (textEnd - textStart == configLength && memcmp(data + textStart, CONFIG_TEXT, configLength) == 0) {
+                bool applied = recordFollows && applyConfigRecord(data + textEnd, messageEnd - textEnd);
+                playMelody(applied ? READOUT_END_MELODY : ERROR_MELODY,
+                           applied ? READOUT_END_MELODY_LENGTH : ERROR_MELODY_LENGTH);
+                return true;
+              }
+
               // Extract checkpoint number
               if (textStart + 4 < dataLength) {
                 char digit1 = data[textStart + 3];
@@ -225,7 +532,19 @@ bool parseNdefRecord(uint8_t* data, uint16_t dataLength) {
                       LOGLN_INFO(courseLen);
                     }
 
-                    processCheckpoint(checkpoint, courseLen);
+                    if (checkpoint == 0) {
+                      // A manifest after the text record replaces the tag cache; without
+                      // one, what earlier runs learned is kept unless the course changed
+                      if (recordFollows) {
+                        loadCourseManifest(data + textEnd, messageEnd - textEnd, courseLen);
+                      } else {
+                        startTagCacheCourse(courseLen);
+                      }
+                    } else {
+                      cacheTag(nfcReaders[reader].uid, nfcReaders[reader].uidLength, TAG_KIND_CHECKPOINT, checkpoint);
+                    }
+
+                    processCheckpoint(checkpoint, courseLen, reader);
                     return true;
                 } else {
                   LOGLN_WARN(F("Invalid checkpoint digits"));
@@ -285,9 +604,12 @@ bool parseNdefRecord(uint8_t* data, uint16_t dataLength) {
             LOG_DEBUG(F("Complete URL: "));
             LOGLN_DEBUG(url);
 
-            if (url.startsWith("https://kor.swarm.ostuda.net/")) {
+            // Any page on the host of the profile's readout prefix
+            if (url.startsWith("https://") &&
+                strncmp(url.c_str() + 8, stationConfig.readoutPrefix, readoutHostLength()) == 0) {
               LOGLN_INFO(F("Found readout trigger"));
-              processReadoutTrigger();
+              cacheTag(nfcReaders[reader].uid, nfcReaders[reader].uidLength, TAG_KIND_READOUT, 0);
+              processReadoutTrigger(reader);
               return true;
             } else {
               LOGLN_WARN(F("URL doesn't match expected pattern"));
@@ -304,126 +626,55 @@ bool parseNdefRecord(uint8_t* data, uint16_t dataLength) {
   return false;
 }
 
-bool writeUrlToNfc(String url) {
-  // Create NDEF URL record
-  uint8_t ndef_data[144];  // Match read buffer size for consistency
-  uint16_t ndef_length = 0;
-
-  // NDEF Message header
-  ndef_data[ndef_length++] = 0x03; // NDEF Message TLV
-
-  // Determine URI payload format
-  String urlSuffix = url;
-  uint8_t uriCode = 0x00; // Default: no prefix
-
-  if (url.startsWith("https://")) {
-    uriCode = 0x04;
-    urlSuffix = url.substring(8); // Remove "https://"
-  } else if (url.startsWith("http://")) {
-    uriCode = 0x03;
-    urlSuffix = url.substring(7); // Remove "http://"
-  }
-
-  // Calculate the total record length first
-  uint16_t payload_length = 1 + urlSuffix.length(); // URI code + URL suffix
-  uint16_t record_length = 1 + 1 + 1 + 1 + payload_length; // TNF + TypeLen + PayloadLen + Type + Payload
-
-  LOG_DEBUG(F("Writing URL: "));
-  LOGLN_DEBUG(url);
-  LOG_DEBUG(F("URI code: 0x"));
-  LOG_DEBUG(uriCode, HEX);
-  LOG_DEBUG(F(", suffix: "));
-  LOGLN_DEBUG(urlSuffix);
-  LOG_DEBUG(F("Record length: "));
-  LOGLN_DEBUG(record_length);
-
-  // Handle NDEF message length (can be 1 or 3 bytes)
-  if (record_length <= 254) {
-    ndef_data[ndef_length++] = record_length; // Single byte length
-  } else {
-    ndef_data[ndef_length++] = 0xFF; // Indicates 3-byte length follows
-    ndef_data[ndef_length++] = (record_length >> 8) & 0xFF; // High byte
-    ndef_data[ndef_length++] = record_length & 0xFF; // Low byte
-  }
-
-  // NDEF Record header
-  if (payload_length <= 255) {
-    ndef_data[ndef_length++] = 0xD1; // TNF=1 (Well Known), MB=1, ME=1, SR=1 (short record)
-    ndef_data[ndef_length++] = 0x01; // Type length = 1
-    ndef_data[ndef_length++] = payload_length; // Payload length (single byte)
-    ndef_data[ndef_length++] = 'U'; // Type = URI
-  } else {
-    ndef_data[ndef_length++] = 0xC1; // TNF=1 (Well Known), MB=1, ME=1, SR=0 (long record)
-    ndef_data[ndef_length++] = 0x01; // Type length = 1
-    ndef_data[ndef_length++] = (payload_length >> 24) & 0xFF; // Payload length (4 bytes)
-    ndef_data[ndef_length++] = (payload_length >> 16) & 0xFF;
-    ndef_data[ndef_length++] = (payload_length >> 8) & 0xFF;
-    ndef_data[ndef_length++] = payload_length & 0xFF;
-    ndef_data[ndef_length++] = 'U'; // Type = URI
-  }
-
-  // URI payload: identifier code + URL suffix
-  ndef_data[ndef_length++] = uriCode;
-  for (uint16_t i = 0; i < urlSuffix.length() && ndef_length < sizeof(ndef_data); i++) {
-    ndef_data[ndef_length++] = urlSuffix[i];
-  }
-
-  // Add terminator TLV
-  ndef_data[ndef_length++] = 0xFE;
-
-  if (LOG_LEVEL <= LOG_LEVEL_DEBUG) {
-    Serial.print(F("Total NDEF data length: "));
-    Serial.println(ndef_length);
-    Serial.println(F("NDEF data to write:"));
-    for (uint16_t i = 0; i < ndef_length; i++) {
-      if (i % 16 == 0) {
-        Serial.print(F("0x"));
-        if (i < 0x100) Serial.print(F("0"));
-        if (i < 0x10) Serial.print(F("0"));
-        Serial.print(i, HEX);
-        Serial.print(F(": "));
-      }
-      if (ndef_data[i] < 0x10) Serial.print(F("0"));
-      Serial.print(ndef_data[i], HEX);
-      Serial.print(F(" "));
-      if ((i + 1) % 16 == 0 || i == ndef_length - 1) {
-        Serial.println();
+bool writeReadoutToNfc(uint8_t reader) {
+  const uint8_t* uid = nfcReaders[reader].uid;
+  uint8_t uidLength = nfcReaders[reader].uidLength;
+
+  uint16_t imageLength;
+  const uint8_t* image = readoutNdefImage(&imageLength);
+  uint8_t imagePages = (imageLength + 3) / 4;
+  uint64_t imageMask = imagePages >= 64 ? ~0ULL : (1ULL << imagePages) - 1;
+  uint64_t pending = readoutPagesToWrite(uid, uidLength);
+  uint64_t confirmed = 0;  // Pages known to hold the image: read back or written with an ACK
+  uint8_t pageCount = 0;
+
+  // Pages this station wrote before may have been overwritten by another
+  // station or torn by an early lift, so they are only skipped once a read
+  // shows they still match
+  if (pending != imageMask) {
+    static uint8_t onTag[READOUT_IMAGE_SIZE];
+    if (readNfcPagesFast(reader, READOUT_FIRST_PAGE, READOUT_FIRST_PAGE + imagePages - 1, onTag)) {
+      for (uint8_t i = 0; i < imagePages; i++) {
+        uint8_t size = i * 4 + 4 <= imageLength ? 4 : imageLength - i * 4;
+        if (memcmp(onTag + i * 4, image + i * 4, size) == 0) {
+          confirmed |= 1ULL << i;
+        }
       }
     }
+    pending = imageMask & ~confirmed;
   }
 
-  // Write to NFC card starting at page 4
-  uint8_t page = 4;
-  uint16_t offset = 0;
-
-  while (offset < ndef_length) {
-    uint8_t page_data[4] = {0, 0, 0, 0};
-
-    for (uint8_t i = 0; i < 4 && offset + i < ndef_length; i++) {
-      page_data[i] = ndef_data[offset + i];
-    }
+  for (uint8_t i = 0; i < imagePages; i++) {
+    if (!(pending & (1ULL << i))) continue;
 
-    if (!nfc.ntag2xx_WritePage(page, page_data)) {
+    uint8_t page = READOUT_FIRST_PAGE + i;
+    if (!writeNfcPage(reader, page, image + i * 4)) {
       LOG_WARN(F("Failed to write page "));
       LOGLN_WARN(page);
+      recordFlight(FLIGHT_WRITE_READOUT, reader, page, nullptr, image, imageLength);
+      markReadoutPagesWritten(uid, uidLength, confirmed);
       return false;
     }
-
-    LOG_DEBUG(F("Wrote page "));
-    LOG_DEBUG(page);
-    LOG_DEBUG(F(": "));
-    for (uint8_t i = 0; i < 4; i++) {
-      if (page_data[i] < 0x10) LOG_DEBUG(F("0"));
-      LOG_DEBUG(page_data[i], HEX);
-      LOG_DEBUG(F(" "));
-    }
-    LOGLN_DEBUG(F(""));
-
-    page++;
-    offset += 4;
-
-    if (page > 39) break; // Don't exceed NTAG213 user memory (pages 4-39)
+    confirmed |= 1ULL << i;
+    pageCount++;
   }
 
-  return true;
+  markReadoutPagesWritten(uid, uidLength, confirmed);
+
+  LOG_INFO(F("Wrote "));
+  LOG_INFO(pageCount);
+  LOG_INFO(F(" of "));
+  LOG_INFO(imagePages);
+  LOGLN_INFO(F(" readout pages"));
+  return (confirmed & imageMask) == imageMask;
 }
@@ -0,0 +1,387 @@
+#include <Arduino.h>
+#include <korcodec.h>
+#include "config.h"
+#include "flightrec.h"
+#include "logging.h"
+#include "melodies.h"
+#include "nfc.h"
+#include "serialize.h"
+#include "tagcache.h"
+
+#include "provision.h"
+
+// A manifest on the start tag has to fit in pages 4-39 next to "KOR00/NN"
+const uint8_t START_MANIFEST_MAX = 14;
+const uint8_t PROVISION_CHECK_SIZE = 4;
+
+static const uint8_t checkKey[kor::MAC_KEY_SIZE] = READOUT_MAC_KEY;
+
+struct ManifestEntry {
+  uint8_t checkpoint;  // MANIFEST_READOUT for readout tags
+  uint8_t uid[7];
+};
+
+static uint8_t mode = PROVISION_OFF;
+static uint8_t nextNumber = 0;   // Next control, or the course length for start tags
+static uint8_t lastNumber = 0;
+static bool lockTags = false;
+
+// The provisioning tag that started this session; tapping it again stops it
+static uint8_t provisioningUid[7];
+static uint8_t provisioningUidLength = 0;
+
+static ManifestEntry manifest[PROVISION_MANIFEST_SIZE];
+static uint8_t manifestCount = 0;
+
+void startProvisioning(uint8_t newMode, uint8_t first, uint8_t last, bool lock) {
+  mode = newMode;
+  nextNumber = first;
+  lastNumber = last;
+  lockTags = lock;
+  provisioningUidLength = 0;
+
+  LOG_INFO(F("Provisioning "));
+  if (mode == PROVISION_START) {
+    LOG_INFO(F("start tags KOR00/"));
+    LOG_INFO(first);
+  } else if (mode == PROVISION_CONTROLS) {
+    LOG_INFO(F("controls from KOR"));
+    if (first < 10) LOG_INFO(F("0"));
+    LOG_INFO(first);
+  } else if (mode == PROVISION_CONFIG) {
+    LOG_INFO(F("configuration tags"));
+  } else if (mode == PROVISION_TAGS) {
+    LOG_INFO(F("provisioning tags from KOR"));
+    if (first < 10) LOG_INFO(F("0"));
+    LOG_INFO(first);
+  } else {
+    LOG_INFO(F("readout tags"));
+  }
+  LOGLN_INFO(lock ? F(", locking") : F(""));
+  playMelody(READOUT_START_MELODY, READOUT_START_MELODY_LENGTH);
+}
+
+void stopProvisioning() {
+  if (mode == PROVISION_OFF) return;
+  mode = PROVISION_OFF;
+  LOG_INFO(F("Provisioning stopped, "));
+  LOG_INFO(manifestCount);
+  LOGLN_INFO(F(" tags in manifest"));
+  playMelody(READOUT_END_MELODY, READOUT_END_MELODY_LENGTH);
+}
+
+bool isProvisioning() {
+  return mode != PROVISION_OFF;
+}
+
+static uint16_t appendTextRecord(uint8_t* message, uint16_t n, const char* text, bool lastRecord) {
+  uint8_t textLength = strlen(text);
+  message[n++] = lastRecord ? 0xD1 : 0x91;  // TNF=1 (Well Known), MB=1, SR=1, ME on the last record
+  message[n++] = 0x01;                      // Type length = 1
+  message[n++] = 3 + textLength;            // Status byte + "en" + text
+  message[n++] = 'T';
+  message[n++] = 0x02;                      // UTF-8, language code length 2
+  message[n++] = 'e';
+  message[n++] = 'n';
+  memcpy(message + n, text, textLength);
+  return n + textLength;
+}
+
+static uint32_t provisioningCheck(const uint8_t* text, uint8_t length) {
+  return (uint32_t)kor::sipHash24(checkKey, text, length);
+}
+
+// Controls and readout tags written so far, in the course manifest record format
+static uint8_t manifestTagCount() {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < manifestCount; i++) {
+    if (manifest[i].checkpoint != 0) count++;
+  }
+  return count;
+}
+
+// NDEF message TLV for the next tag, terminator included
+static uint16_t buildMessage(uint8_t* message) {
+  uint16_t n = 2;  // TLV header filled in below
+  char text[16];
+
+  if (mode == PROVISION_START) {
+    snprintf(text, sizeof(text), "KOR00/%02u", nextNumber);
+    uint8_t tags = manifestTagCount();
+    bool withManifest = tags > 0 && tags <= START_MANIFEST_MAX;
+    if (tags > START_MANIFEST_MAX) {
+      LOGLN_WARN(F("Too many tags for a manifest on the start tag"));
+    }
+
+    n = appendTextRecord(message, n, text, !withManifest);
+    if (withManifest) {
+      const uint8_t typeLength = sizeof(MANIFEST_RECORD_TYPE) - 1;
+      message[n++] = 0x54;  // TNF=4 (External), ME=1, SR=1
+      message[n++] = typeLength;
+      message[n++] = tags * 8;
+      memcpy(message + n, MANIFEST_RECORD_TYPE, typeLength);
+      n += typeLength;
+      for (uint8_t i = 0; i < manifestCount; i++) {
+        if (manifest[i].checkpoint == 0) continue;
+        message[n++] = manifest[i].checkpoint;
+        memcpy(message + n, manifest[i].uid, 7);
+        n += 7;
+      }
+    }
+  } else if (mode == PROVISION_CONTROLS) {
+    snprintf(text, sizeof(text), "KOR%02u", nextNumber);
+    n = appendTextRecord(message, n, text, true);
+  } else if (mode == PROVISION_CONFIG) {
+    n = appendTextRecord(message, n, CONFIG_TEXT, false);
+    n += buildConfigRecord(message + n);
+  } else if (mode == PROVISION_TAGS) {
+    snprintf(text, sizeof(text), PROVISION_TEXT "/%02u%s", nextNumber, lockTags ? "L" : "");
+    uint32_t check = provisioningCheck((const uint8_t*)text, strlen(text));
+    const uint8_t typeLength = sizeof(PROVISION_RECORD_TYPE) - 1;
+    n = appendTextRecord(message, n, text, false);
+    message[n++] = 0x54;  // TNF=4 (External), ME=1, SR=1
+    message[n++] = typeLength;
+    message[n++] = PROVISION_CHECK_SIZE;
+    memcpy(message + n, PROVISION_RECORD_TYPE, typeLength);
+    n += typeLength;
+    memcpy(message + n, &check, sizeof(check));
+    n += sizeof(check);
+  } else {
+    // Readout trigger: the page of the profile's readout prefix without its
+    // query; parseNdefRecord() only checks the host
+    const char* uri = stationConfig.readoutPrefix;
+    const char* query = strchr(uri, '?');
+    uint8_t uriLength = query ? query - uri : strlen(uri);
+    message[n++] = 0xD1;
+    message[n++] = 0x01;
+    message[n++] = 1 + uriLength;
+    message[n++] = 'U';
+    message[n++] = 0x04;  // "https://"
+    memcpy(message + n, uri, uriLength);
+    n += uriLength;
+  }
+
+  message[0] = 0x03;  // NDEF Message TLV
+  message[1] = n - 2;
+  message[n++] = 0xFE;
+  return n;
+}
+
+// Make the tag read-only: CC write access, dynamic lock bits, then the static
+// lock bits, which also lock the CC page. All of these are one-time.
+static bool lockTag(uint8_t reader) {
+  uint8_t version[8];
+  if (!readNfcVersion(reader, version)) {
+    return false;
+  }
+
+  uint8_t dynamicLockPage;
+  uint8_t dynamicLock[4] = { 0xFF, 0x00, 0x00, 0x00 };
+  switch (version[6]) {  // Storage size
+    case 0x0F: dynamicLockPage = 40; dynamicLock[1] = 0x0F; break;   // NTAG213
+    case 0x11: dynamicLockPage = 130; break;                         // NTAG215
+    case 0x13: dynamicLockPage = 226; dynamicLock[1] = 0x3F; break;  // NTAG216
+    default:
+      LOGLN_WARN(F("Unknown tag type, not locked"));
+      return false;
+  }
+
+  const uint8_t readOnlyCc[4] = { 0x00, 0x00, 0x00, 0x0F };
+  const uint8_t staticLock[4] = { 0x00, 0x00, 0xFF, 0xFF };
+  return writeNfcPage(reader, 3, readOnlyCc) &&
+         writeNfcPage(reader, dynamicLockPage, dynamicLock) &&
+         writeNfcPage(reader, 2, staticLock);
+}
+
+static void logUid(const uint8_t* uid, uint8_t uidLength) {
+  for (uint8_t i = 0; i < uidLength; i++) {
+    if (uid[i] < 0x10) LOG_INFO(F("0"));
+    LOG_INFO(uid[i], HEX);
+  }
+}
+
+static const ManifestEntry* findManifestEntry(const uint8_t* uid, uint8_t uidLength) {
+  for (uint8_t i = 0; i < manifestCount; i++) {
+    if (memcmp(manifest[i].uid, uid, uidLength) == 0) return &manifest[i];
+  }
+  return nullptr;
+}
+
+void provisionNfcCard(uint8_t reader) {
+  if (!detectNfcTag(reader)) {
+    return;
+  }
+
+  const uint8_t* uid = nfcReaders[reader].uid;
+  uint8_t uidLength = nfcReaders[reader].uidLength;
+  if (uidLength == provisioningUidLength && memcmp(uid, provisioningUid, uidLength) == 0) {
+    acceptNfcTap(reader);
+    stopProvisioning();
+    return;
+  }
+
+  // A tag tapped again after the cooldown keeps its number, so no control
+  // appears twice in the manifest
+  bool listed = mode != PROVISION_CONFIG && mode != PROVISION_TAGS;
+  const ManifestEntry* known = listed ? findManifestEntry(uid, uidLength) : nullptr;
+  if (known) {
+    acceptNfcTap(reader);
+    LOG_WARN(F("Tag already provisioned as "));
+    if (known->checkpoint == MANIFEST_READOUT) {
+      LOGLN_WARN(F("readout"));
+    } else {
+      LOG_WARN(F("KOR"));
+      if (known->checkpoint < 10) LOG_WARN(F("0"));
+      LOGLN_WARN(known->checkpoint);
+    }
+    playMelody(MISS_MELODY, MISS_MELODY_LENGTH);
+    return;
+  }
+
+  uint32_t started = millis();
+  uint8_t message[(39 - 4 + 1) * 4];
+  uint16_t length = buildMessage(message);
+
+  // Write, then read back in 16-byte blocks
+  bool ok = true;
+  for (uint16_t offset = 0; ok && offset < length; offset += 4) {
+    uint8_t page[4] = { 0, 0, 0, 0 };
+    memcpy(page, message + offset, length - offset < 4 ? length - offset : 4);
+    ok = writeNfcPage(reader, 4 + offset / 4, page);
+  }
+  uint32_t written = millis();
+
+  for (uint16_t offset = 0; ok && offset < length; offset += 16) {
+    uint8_t block[16];
+    uint16_t compare = length - offset < 16 ? length - offset : 16;
+    ok = readNfcPages(reader, 4 + offset / 4, block) && memcmp(block, message + offset, compare) == 0;
+  }
+  uint32_t verified = millis();
+
+  // On provisioning tags the lock flag is for the controls they provision
+  bool lock = lockTags && mode != PROVISION_TAGS;
+  if (ok && lock) {
+    ok = lockTag(reader);
+  }
+  uint32_t locked = millis();
+
+  // Per-tag timing log
+  if (mode == PROVISION_START) {
+    LOG_INFO(F("KOR00/"));
+    LOG_INFO(nextNumber);
+  } else if (mode == PROVISION_CONTROLS) {
+    LOG_INFO(F("KOR"));
+    if (nextNumber < 10) LOG_INFO(F("0"));
+    LOG_INFO(nextNumber);
+  } else if (mode == PROVISION_CONFIG) {
+    LOG_INFO(F(CONFIG_TEXT));
+  } else if (mode == PROVISION_TAGS) {
+    LOG_INFO(F(PROVISION_TEXT "/"));
+    LOG_INFO(nextNumber);
+  } else {
+    LOG_INFO(F("readout"));
+  }
+  LOG_INFO(F(" "));
+  logUid(uid, uidLength);
+  LOG_INFO(F(" write "));
+  LOG_INFO(written - started);
+  LOG_INFO(F(" ms, verify "));
+  LOG_INFO(verified - written);
+  if (lock) {
+    LOG_INFO(F(" ms, lock "));
+    LOG_INFO(locked - verified);
+  }
+  LOG_INFO(F(" ms, total "));
+  LOG_INFO(locked - started);
+  LOGLN_INFO(ok ? F(" ms OK") : F(" ms FAILED"));
+
+  if (!ok) {
+    recordFlight(FLIGHT_WRITE_PROVISION, reader, 0, nullptr, message, length);
+    // No cooldown: the same tag is retried on the next poll
+    tone(BUZZER_PIN, ERROR_MELODY[0].frequency, 150);
+    return;
+  }
+
+  acceptNfcTap(reader);
+  if (listed && manifestCount < PROVISION_MANIFEST_SIZE) {
+    ManifestEntry& entry = manifest[manifestCount++];
+    entry.checkpoint = mode == PROVISION_CONTROLS ? nextNumber : mode == PROVISION_READOUT ? MANIFEST_READOUT : 0;
+    memcpy(entry.uid, uid, 7);
+  }
+  playSuccessTone();
+
+  if (mode == PROVISION_CONTROLS) {
+    if (nextNumber >= lastNumber) {
+      stopProvisioning();
+    } else {
+      nextNumber++;
+    }
+  }
+}
+
+bool parseProvisioningText(const uint8_t* text, uint8_t length, const uint8_t* record, uint16_t recordLength,
+                           uint8_t reader) {
+  const uint8_t textLength = sizeof(PROVISION_TEXT) - 1;
+  if (length < textLength || memcmp(text, PROVISION_TEXT, textLength) != 0) {
+    return false;
+  }
+
+  // Short external record: [flags][type length][payload length][type][check]
+  const uint8_t typeLength = sizeof(PROVISION_RECORD_TYPE) - 1;
+  uint32_t check;
+  if (!record || recordLength < 3 + typeLength + PROVISION_CHECK_SIZE || (record[0] & 0x1F) != 0x14 ||
+      record[1] != typeLength || record[2] != PROVISION_CHECK_SIZE ||
+      memcmp(record + 3, PROVISION_RECORD_TYPE, typeLength) != 0) {
+    LOGLN_WARN(F("Provisioning tag without a check, ignored"));
+    playMelody(ERROR_MELODY, ERROR_MELODY_LENGTH);
+    return true;
+  }
+  memcpy(&check, record + 3 + typeLength, sizeof(check));
+  if (check != provisioningCheck(text, length)) {
+    LOGLN_WARN(F("Provisioning tag not made for this station key"));
+    playMelody(ERROR_MELODY, ERROR_MELODY_LENGTH);
+    return true;
+  }
+
+  // Optional "/NN" first control and "L" to lock
+  uint8_t first = 1;
+  bool lock = false;
+  uint8_t i = textLength;
+  if (i + 2 < length && text[i] == '/' &&
+      text[i + 1] >= '0' && text[i + 1] <= '9' && text[i + 2] >= '0' && text[i + 2] <= '9') {
+    first = (text[i + 1] - '0') * 10 + (text[i + 2] - '0');
+    i += 3;
+  }
+  if (i < length && text[i] == 'L') {
+    lock = true;
+  }
+  if (first < 1 || first > 98) {
+    LOGLN_WARN(F("Provisioning tag with an invalid first control"));
+    playMelody(ERROR_MELODY, ERROR_MELODY_LENGTH);
+    return true;
+  }
+
+  startProvisioning(PROVISION_CONTROLS, first, 98, lock);
+  memcpy(provisioningUid, nfcReaders[reader].uid, nfcReaders[reader].uidLength);
+  provisioningUidLength = nfcReaders[reader].uidLength;
+  return true;
+}
+
+void printProvisionManifest() {
+  Serial.println(F("checkpoint,uid"));
+  for (uint8_t i = 0; i < manifestCount; i++) {
+    if (manifest[i].checkpoint == MANIFEST_READOUT) {
+      Serial.print(F("readout"));
+    } else {
+      Serial.print(F("KOR"));
+      if (manifest[i].checkpoint < 10) Serial.print(F("0"));
+      Serial.print(manifest[i].checkpoint);
+    }
+    Serial.print(F(","));
+    for (uint8_t j = 0; j < 7; j++) {
+      if (manifest[i].uid[j] < 0x10) Serial.print(F("0"));
+      Serial.print(manifest[i].uid[j], HEX);
+    }
+    Serial.println();
+  }
+}
@@ -0,0 +1,176 @@
+#include <Arduino.h>
+#include "config.h"
+#include "logging.h"
+#include "melodies.h"
+#include "nfc.h"
+
+#include "rfdiag.h"
+
+const uint32_t RF_DIAG_BURST = 400;       // ms of back-to-back cycles per poll, keeps the console responsive
+const uint8_t RF_DIAG_FIRST_PAGE = 4;
+const uint8_t RF_DIAG_LAST_PAGE = 39;     // NTAG213 user memory, as read on a tap
+
+static bool running = false;
+static uint8_t diagReader = 0;
+static uint16_t cyclesLeft = 0;
+static RfDiagReport report;
+static uint8_t pages[(RF_DIAG_LAST_PAGE - RF_DIAG_FIRST_PAGE + 1) * 4];
+
+static const char* const OP_NAMES[RF_DIAG_OPS] = { "detect", "read", "fast_read", "tap_read" };
+
+void startRfDiag(uint16_t cycles, uint8_t reader) {
+  memset(&report, 0, sizeof(report));
+  report.reader = reader;
+  diagReader = reader;
+  cyclesLeft = cycles;
+  running = true;
+
+  LOG_INFO(F("RF diagnostics on reader "));
+  LOG_INFO(reader + 1);
+  LOG_INFO(F(", "));
+  LOG_INFO(cycles);
+  LOGLN_INFO(F(" cycles, hold a tag on the antenna"));
+  playMelody(READOUT_START_MELODY, READOUT_START_MELODY_LENGTH);
+}
+
+void stopRfDiag() {
+  if (!running) return;
+  running = false;
+  printRfDiagReport();
+  playMelody(READOUT_END_MELODY, READOUT_END_MELODY_LENGTH);
+}
+
+bool isRfDiagRunning() {
+  return running;
+}
+
+const RfDiagReport& rfDiagReport() {
+  return report;
+}
+
+static bool detectOp(uint8_t reader) {
+  return selectNfcTag(reader);
+}
+
+static bool readOp(uint8_t reader) {
+  return readNfcPages(reader, RF_DIAG_FIRST_PAGE, pages);
+}
+
+static bool fastReadOp(uint8_t reader) {
+  return readNfcPagesFast(reader, RF_DIAG_FIRST_PAGE, RF_DIAG_LAST_PAGE, pages);
+}
+
+// Same exchanges as readNfcCard() for an unknown tag
+static bool tapReadOp(uint8_t reader) {
+  Adafruit_PN532& nfc = nfcReaders[reader].pn532;
+  uint8_t cc[4];
+  if (!selectNfcTag(reader) || !nfc.ntag2xx_ReadPage(3, cc)) return false;
+  for (uint8_t page = RF_DIAG_FIRST_PAGE; page <= RF_DIAG_LAST_PAGE; page++) {
+    if (!nfc.ntag2xx_ReadPage(page, pages + (page - RF_DIAG_FIRST_PAGE) * 4)) return false;
+  }
+  return true;
+}
+
+// Run one operation up to RF_DIAG_ATTEMPTS times and time the attempt that
+// worked. A failed exchange leaves the tag unselected, so later attempts
+// select it again first, outside the measured time.
+static bool timeOp(uint8_t op, uint8_t reader, bool (*run)(uint8_t)) {
+  RfDiagStats& stats = report.ops[op];
+  for (uint8_t attempt = 0; attempt < RF_DIAG_ATTEMPTS; attempt++) {
+    if (attempt > 0) {
+      stats.retries++;
+      if (op == RF_DIAG_OP_READ || op == RF_DIAG_OP_FAST_READ) selectNfcTag(reader);
+    }
+    uint32_t start = micros();
+    if (run(reader)) {
+      uint32_t elapsed = micros() - start;
+      stats.samples[stats.ok % RF_DIAG_SAMPLES] = elapsed;
+      if (elapsed > stats.slowest) stats.slowest = elapsed;
+      stats.ok++;
+      return true;
+    }
+  }
+  stats.failed++;
+  return false;
+}
+
+static void runCycle(uint8_t reader) {
+  report.cycles++;
+  if (!timeOp(RF_DIAG_OP_DETECT, reader, detectOp)) {
+    report.noTag++;
+    return;
+  }
+  memcpy(report.uid, nfcReaders[reader].uid, nfcReaders[reader].uidLength);
+  report.uidLength = nfcReaders[reader].uidLength;
+
+  timeOp(RF_DIAG_OP_READ, reader, readOp);
+  timeOp(RF_DIAG_OP_FAST_READ, reader, fastReadOp);
+  timeOp(RF_DIAG_OP_TAP_READ, reader, tapReadOp);
+}
+
+void runRfDiag(uint8_t reader) {
+  if (reader != diagReader) return;
+
+  uint32_t start = millis();
+  while (cyclesLeft > 0 && millis() - start < RF_DIAG_BURST) {
+    runCycle(reader);
+    cyclesLeft--;
+  }
+  if (cyclesLeft == 0) {
+    stopRfDiag();
+  }
+}
+
+// Latency percentile of the kept samples, `sorted` in ascending order
+static uint32_t percentile(const uint32_t* sorted, uint8_t count, uint8_t percent) {
+  return count > 0 ? sorted[(count - 1) * percent / 100] : 0;
+}
+
+static void formatMs(char* text, size_t size, uint32_t us) {
+  snprintf(text, size, "%5lu.%lu", (unsigned long)(us / 1000), (unsigned long)(us / 100 % 10));
+}
+
+void printRfDiagReport() {
+  char text[96];
+
+  Serial.print(F("RF diagnostics, reader "));
+  Serial.print(report.reader + 1);
+  Serial.print(F(", tag "));
+  for (uint8_t i = 0; i < report.uidLength; i++) {
+    if (report.uid[i] < 0x10) Serial.print(F("0"));
+    Serial.print(report.uid[i], HEX);
+  }
+  if (report.uidLength == 0) Serial.print(F("none"));
+  snprintf(text, sizeof(text), ", %u cycles, %u without a tag", report.cycles, report.noTag);
+  Serial.println(text);
+  Serial.println(F("op          ok  fail retry   ok %   p50 ms   p95 ms   max ms"));
+
+  for (uint8_t op = 0; op < RF_DIAG_OPS; op++) {
+    const RfDiagStats& stats = report.ops[op];
+    uint8_t count = stats.ok < RF_DIAG_SAMPLES ? stats.ok : RF_DIAG_SAMPLES;
+    uint32_t sorted[RF_DIAG_SAMPLES];
+    for (uint8_t i = 0; i < count; i++) {
+      uint32_t value = stats.samples[i];
+      uint8_t j = i;
+      for (; j > 0 && sorted[j - 1] > value; j--) sorted[j] = sorted[j - 1];
+      sorted[j] = value;
+    }
+
+    uint16_t attempts = stats.ok + stats.failed;
+    uint16_t permille = attempts > 0 ? (uint32_t)stats.ok * 1000 / attempts : 0;
+    char p50[12], p95[12], slowest[12];
+    formatMs(p50, sizeof(p50), percentile(sorted, count, 50));
+    formatMs(p95, sizeof(p95), percentile(sorted, count, 95));
+    formatMs(slowest, sizeof(slowest), stats.slowest);
+    snprintf(text, sizeof(text), "%-10s %4u %5u %5u %4u.%u %s %s %s", OP_NAMES[op], stats.ok, stats.failed,
+             stats.retries, permille / 10, permille % 10, p50, p95, slowest);
+    Serial.println(text);
+
+    // The slowest complete read is how long a tag has to stay once it is polled
+    if (op == RF_DIAG_OP_TAP_READ && stats.ok > 0) {
+      snprintf(text, sizeof(text), "Minimum dwell for a complete read:%s ms, plus up to %lu ms until polled", slowest,
+               (unsigned long)(stationConfig.pollInterval + stationConfig.loopDelay));
+      Serial.println(text);
+    }
+  }
+}
@@ -1,77 +1,170 @@
 #include <Arduino.h>
+#include <korcodec.h>
 
+#include "config.h"
 #include "serialize.h"
 #include "main.h"
 
+// Payload format (course length, then 4 bytes per press, base64url) is
+// defined in lib/korcodec, shared with the host tools.
+//
+// The blob only ever grows at the end, so the base64url text is extended one
+// press at a time: 3-byte groups are encoded once, only the trailing partial
+// group is re-encoded. The MAC chain is extended the same way, one press at
+// a time.
+
+const uint16_t BINARY_CAPACITY = 1 + 100 * kor::PRESS_SIZE;
+const uint16_t ENCODED_CAPACITY = (BINARY_CAPACITY + 2) / 3 * 4;
+
+// NDEF layout: [03][len] [D1][01][payloadLen]['U'] [uriCode][prefix...][payload...][&m=mac] [FE]
+const uint8_t NDEF_TLV_LENGTH_INDEX = 1;
+const uint8_t NDEF_PAYLOAD_LENGTH_INDEX = 4;
+const uint8_t NDEF_PREFIX_INDEX = 7;
+const uint8_t MAC_PARAM_LENGTH = sizeof(KOR_MAC_PARAM) - 1 + kor::MAC_TEXT_LENGTH;
+
+static const uint8_t macKey[kor::MAC_KEY_SIZE] = READOUT_MAC_KEY;
+
+static uint8_t binaryData[BINARY_CAPACITY];
+static uint16_t binaryLength = 0;
+static char encodedText[ENCODED_CAPACITY + 1];
+static uint16_t encodedLength = 0;
+static uint64_t mac = 0;
+static char encodedMac[kor::MAC_TEXT_LENGTH + 1];
+
+// The URL prefix comes from the station profile and is fixed at each reset.
+// The text leaves room for the MAC and the terminator; a longer table stops
+// at the last press that fits, so the MAC in the image always covers exactly
+// its text.
+static uint8_t prefixLength = 0;
+static uint8_t payloadIndex = NDEF_PREFIX_INDEX;
+static uint16_t imageTextCapacity = 0;
+
+static uint8_t ndefImage[READOUT_IMAGE_SIZE];
+static uint16_t ndefLength = 0;  // Including the terminator TLV
+static bool imageInitialized = false;
+
+// Pages that differ from what was last written to writtenUid
+static uint64_t dirtyPages = 0;
+static uint8_t writtenUid[7];
+static uint8_t writtenUidLength = 0;
+
+static void setImageByte(uint16_t index, uint8_t value) {
+  if (ndefImage[index] != value || !imageInitialized) {
+    ndefImage[index] = value;
+    dirtyPages |= 1ULL << (index / 4);
+  }
+}
+
+// Refresh the image from text position `from` onwards; the text has to fit
+static void updateNdefImage(uint16_t from) {
+  uint16_t textLength = encodedLength;
+  uint8_t macLength = binaryLength > 0 ? MAC_PARAM_LENGTH : 0;
+  uint8_t payloadLength = 1 + prefixLength + textLength + macLength;
+
+  setImageByte(NDEF_TLV_LENGTH_INDEX, 4 + payloadLength);
+  setImageByte(NDEF_PAYLOAD_LENGTH_INDEX, payloadLength);
+  for (uint16_t i = from; i < textLength; i++) {
+    setImageByte(payloadIndex + i, encodedText[i]);
+  }
+  uint16_t index = payloadIndex + textLength;
+  if (macLength > 0) {
+    for (const char* c = KOR_MAC_PARAM; *c != '\0'; c++) {
+      setImageByte(index++, *c);
+    }
+    for (uint8_t i = 0; i < kor::MAC_TEXT_LENGTH; i++) {
+      setImageByte(index++, encodedMac[i]);
+    }
+  }
+  setImageByte(index, 0xFE);
+  ndefLength = index + 1;
+}
 
-// Helper function to encode binary data as base64url
-String binaryToBase64Url(uint8_t* data, uint16_t length) {
-  if (length == 0) return "A";
+void resetReadoutPayload() {
+  binaryLength = 0;
+  encodedLength = 0;
+  encodedText[0] = '\0';
+  encodedMac[0] = '\0';
+
+  // Static part of the message; these bytes only change with the prefix
+  const char* prefix = stationConfig.readoutPrefix;
+  prefixLength = strlen(prefix);
+  payloadIndex = NDEF_PREFIX_INDEX + prefixLength;
+  imageTextCapacity = READOUT_IMAGE_SIZE - payloadIndex - MAC_PARAM_LENGTH - 1;
+  setImageByte(0, 0x03);  // NDEF Message TLV
+  setImageByte(2, 0xD1);  // TNF=1 (Well Known), MB=1, ME=1, SR=1 (short record)
+  setImageByte(3, 0x01);  // Type length = 1
+  setImageByte(5, 'U');   // Type = URI
+  setImageByte(6, READOUT_URI_CODE);
+  for (uint8_t i = 0; i < prefixLength; i++) {
+    setImageByte(NDEF_PREFIX_INDEX + i, prefix[i]);
+  }
+  imageInitialized = true;
 
-  // Base64URL characters: A-Z, a-z, 0-9, -, _
-  const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
-  String result = "";
+  updateNdefImage(0);
+}
 
-  // Process 3 bytes at a time (24 bits -> 4 base64 chars)
-  uint16_t i = 0;
-  while (i + 2 < length) {
-    uint32_t block = (data[i] << 16) | (data[i+1] << 8) | data[i+2];
+void appendReadoutPress(uint8_t courseLen, const CheckpointPress& press) {
+  if (!imageInitialized) resetReadoutPayload();
+  if (binaryLength + kor::PRESS_SIZE > BINARY_CAPACITY) return;
 
-    result += chars[(block >> 18) & 0x3F];
-    result += chars[(block >> 12) & 0x3F];
-    result += chars[(block >> 6) & 0x3F];
-    result += chars[block & 0x3F];
+  uint16_t groupStart = binaryLength / 3 * 3;
 
-    i += 3;
+  // Pack course length
+  if (binaryLength == 0) {
+    binaryData[binaryLength++] = courseLen;
+    mac = kor::macStart(macKey, courseLen);
   }
 
-  // Handle remaining 1 or 2 bytes
-  if (i < length) {
-    uint32_t block = data[i] << 16;
-    if (i + 1 < length) {
-      block |= data[i+1] << 8;
-    }
+  kor::packPress(binaryData + binaryLength, press.checkpoint, press.timestamp);
+  mac = kor::macAddPress(macKey, mac, binaryData + binaryLength);
+  binaryLength += kor::PRESS_SIZE;
+  kor::macText(mac, encodedMac);
+  encodedMac[kor::MAC_TEXT_LENGTH] = '\0';
 
-    result += chars[(block >> 18) & 0x3F];
-    result += chars[(block >> 12) & 0x3F];
+  // Re-encode from the first incomplete group (3 bytes -> 4 chars)
+  encodedLength = groupStart / 3 * 4;
+  encodedLength += kor::base64UrlEncode(binaryData + groupStart, binaryLength - groupStart, encodedText + encodedLength);
+  encodedText[encodedLength] = '\0';
 
-    if (i + 1 < length) {
-      result += chars[(block >> 6) & 0x3F];
-    }
+  if (encodedLength <= imageTextCapacity) {
+    updateNdefImage(groupStart / 3 * 4);
   }
-
-  return result;
 }
 
 String serializePressTable() {
-  if (pressCount == 0) return "";
+  if (binaryLength == 0) return "";
+  return String(encodedText) + KOR_MAC_PARAM + encodedMac;
+}
+
+const char* readoutPayloadText() {
+  return encodedText;
+}
 
-  // BINARY-PACKED ENCODING FORMAT:
-  // First byte of the binary blob is the course length
-  // Then pack each checkpoint as: [1 byte checkpoint][3 bytes timestamp]
-  // 3 bytes = 24 bits = 16.7M milliseconds = 4.6 hours (plenty for orienteering)
-  // Then base64url-encode the entire binary blob (16% better than base36)
-  // Uses A-Z, a-z, 0-9, -, _ for maximum URL-safe compression
+const char* readoutMacText() {
+  return encodedMac;
+}
 
-  uint16_t binarySize = 1 + pressCount * 4; // 4 bytes per checkpoint
-  uint8_t binaryData[binarySize];
-  uint16_t offset = 1;
+const uint8_t* readoutNdefImage(uint16_t* length) {
+  if (!imageInitialized) resetReadoutPayload();
+  *length = ndefLength;
+  return ndefImage;
+}
 
-  // Pack course length
-  binaryData[0] = courseLength;
-
-  for (uint8_t i = 0; i < pressCount; i++) {
-    // Pack checkpoint number (1 byte)
-    binaryData[offset++] = pressTable[i].checkpoint;
-
-    // Pack timestamp (3 bytes, big-endian) - max 16.7M milliseconds
-    uint32_t timestamp = pressTable[i].timestamp;
-    if (timestamp > 0xFFFFFF) timestamp = 0xFFFFFF; // Clamp to 24-bit max
-    binaryData[offset++] = (timestamp >> 16) & 0xFF;
-    binaryData[offset++] = (timestamp >> 8) & 0xFF;
-    binaryData[offset++] = timestamp & 0xFF;
+uint64_t readoutPagesToWrite(const uint8_t* uid, uint8_t uidLength) {
+  uint8_t imagePages = (ndefLength + 3) / 4;
+  uint64_t imageMask = imagePages >= 64 ? ~0ULL : (1ULL << imagePages) - 1;
+
+  if (uidLength != writtenUidLength || memcmp(uid, writtenUid, uidLength) != 0) {
+    return imageMask;  // Unknown tag: write everything
   }
+  return dirtyPages & imageMask;
+}
 
-  // Convert binary data to base64url
-  return binaryToBase64Url(binaryData, binarySize);
+void markReadoutPagesWritten(const uint8_t* uid, uint8_t uidLength, uint64_t pages) {
+  if (uidLength != writtenUidLength || memcmp(uid, writtenUid, uidLength) != 0) {
+    memcpy(writtenUid, uid, uidLength);
+    writtenUidLength = uidLength;
+    dirtyPages = ~0ULL;
+  }
+  dirtyPages &= ~pages;
 }
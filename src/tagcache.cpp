@@ -0,0 +1,146 @@
+#include <Arduino.h>
+#include "logging.h"
+
+#include "tagcache.h"
+
+#if NFC_TAG_CACHE_PERSIST
+#include <EEPROM.h>
+#endif
+
+const uint8_t MANIFEST_ENTRY_SIZE = 8;
+
+static CachedTag cache[NFC_TAG_CACHE_SIZE];
+static uint8_t cacheCount = 0;
+static uint8_t nextVictim = 0;  // Oldest entry, replaced when the cache is full
+static uint8_t cacheCourseLength = 0;  // Course the entries belong to, 0 if not known
+
+#if NFC_TAG_CACHE_PERSIST
+// EEPROM layout: ['K']['L'][course length][count] then `count` CachedTag entries
+const uint16_t TAG_CACHE_EEPROM_SIZE = 4 + sizeof(cache);
+static_assert(TAG_CACHE_EEPROM_OFFSET + TAG_CACHE_EEPROM_SIZE <= TAG_CACHE_EEPROM_LIMIT,
+              "Tag cache does not fit its EEPROM area");
+
+static void saveTagCache() {
+  EEPROM.write(TAG_CACHE_EEPROM_OFFSET, 'K');
+  EEPROM.write(TAG_CACHE_EEPROM_OFFSET + 1, 'L');
+  EEPROM.write(TAG_CACHE_EEPROM_OFFSET + 2, cacheCourseLength);
+  EEPROM.write(TAG_CACHE_EEPROM_OFFSET + 3, cacheCount);
+  for (uint8_t i = 0; i < cacheCount; i++) {
+    EEPROM.put(TAG_CACHE_EEPROM_OFFSET + 4 + i * sizeof(CachedTag), cache[i]);
+  }
+  EEPROM.commit();
+}
+#else
+static void saveTagCache() {}
+#endif
+
+void loadTagCache() {
+  cacheCount = 0;
+  nextVictim = 0;
+  cacheCourseLength = 0;
+#if NFC_TAG_CACHE_PERSIST
+  EEPROM.begin(EEPROM_SIZE);
+  if (EEPROM.read(TAG_CACHE_EEPROM_OFFSET) != 'K' || EEPROM.read(TAG_CACHE_EEPROM_OFFSET + 1) != 'L') {
+    return;
+  }
+  cacheCourseLength = EEPROM.read(TAG_CACHE_EEPROM_OFFSET + 2);
+  uint8_t count = EEPROM.read(TAG_CACHE_EEPROM_OFFSET + 3);
+  for (uint8_t i = 0; i < count && i < NFC_TAG_CACHE_SIZE; i++) {
+    EEPROM.get(TAG_CACHE_EEPROM_OFFSET + 4 + i * sizeof(CachedTag), cache[i]);
+    cacheCount++;
+  }
+  LOG_INFO(F("Loaded "));
+  LOG_INFO(cacheCount);
+  LOGLN_INFO(F(" known tags"));
+#endif
+}
+
+static void resetTagCache(uint8_t courseLength) {
+  cacheCount = 0;
+  nextVictim = 0;
+  cacheCourseLength = courseLength;
+}
+
+// Also empties the persisted copy, so the entries do not return after a reboot
+void clearTagCache() {
+  resetTagCache(0);
+  saveTagCache();
+}
+
+void startTagCacheCourse(uint8_t courseLength) {
+  if (courseLength == 0 || courseLength == cacheCourseLength) return;
+  resetTagCache(courseLength);
+  saveTagCache();
+  LOGLN_INFO(F("New course, known tags cleared"));
+}
+
+const CachedTag* findCachedTag(const uint8_t* uid, uint8_t uidLength) {
+  for (uint8_t i = 0; i < cacheCount; i++) {
+    if (cache[i].uidLength == uidLength && memcmp(cache[i].uid, uid, uidLength) == 0) {
+      return &cache[i];
+    }
+  }
+  return nullptr;
+}
+
+static void storeTag(const uint8_t* uid, uint8_t uidLength, uint8_t kind, uint8_t checkpoint) {
+  CachedTag* entry = (CachedTag*)findCachedTag(uid, uidLength);
+  if (!entry) {
+    if (cacheCount < NFC_TAG_CACHE_SIZE) {
+      entry = &cache[cacheCount++];
+    } else {
+      entry = &cache[nextVictim];
+      nextVictim = (nextVictim + 1) % NFC_TAG_CACHE_SIZE;
+    }
+  }
+  memcpy(entry->uid, uid, uidLength);
+  entry->uidLength = uidLength;
+  entry->kind = kind;
+  entry->checkpoint = checkpoint;
+}
+
+void cacheTag(const uint8_t* uid, uint8_t uidLength, uint8_t kind, uint8_t checkpoint) {
+  const CachedTag* known = findCachedTag(uid, uidLength);
+  if (known && known->kind == kind && known->checkpoint == checkpoint) {
+    return;
+  }
+  storeTag(uid, uidLength, kind, checkpoint);
+  saveTagCache();
+}
+
+uint8_t loadCourseManifest(const uint8_t* record, uint16_t length, uint8_t courseLength) {
+  resetTagCache(courseLength);  // Saved once below, whatever the outcome
+
+  // Short external record (TNF=4, SR=1) of the manifest type
+  const uint8_t typeLength = sizeof(MANIFEST_RECORD_TYPE) - 1;
+  if (length < 3 + typeLength || (record[0] & 0x1F) != 0x14 || record[1] != typeLength ||
+      memcmp(record + 3, MANIFEST_RECORD_TYPE, typeLength) != 0) {
+    saveTagCache();
+    return 0;
+  }
+
+  uint8_t payloadLength = record[2];
+  const uint8_t* payload = record + 3 + typeLength;
+  if (3 + typeLength + payloadLength > length) {
+    saveTagCache();
+    return 0;
+  }
+
+  uint8_t loaded = 0;
+  for (uint8_t i = 0; i + MANIFEST_ENTRY_SIZE <= payloadLength && loaded < NFC_TAG_CACHE_SIZE;
+       i += MANIFEST_ENTRY_SIZE) {
+    uint8_t checkpoint = payload[i];
+    if (checkpoint == MANIFEST_READOUT) {
+      storeTag(payload + i + 1, 7, TAG_KIND_READOUT, 0);
+    } else {
+      storeTag(payload + i + 1, 7, TAG_KIND_CHECKPOINT, checkpoint);
+    }
+    loaded++;
+  }
+  saveTagCache();
+
+  LOG_INFO(F("Course manifest: "));
+  LOG_INFO(loaded);
+  LOGLN_INFO(F(" tags"));
+  return loaded;
+}
@@ -0,0 +1,170 @@
+// Tag cache latency: runners go round a 12-control course, start tag to
+// finish tag, while the real firmware (src/) talks to an emulated PN532.
+// Measures, per control tap, how long the tag has to stay in the field after
+// the station detected it until the beep, and how many tag commands (READ,
+// WRITE) that took: cold (tags never seen), warm (next run of the course),
+// preloaded from a course manifest on the start tag, and after a power cycle
+// with the cache persisted in flash.
+
+#include <Arduino.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+
+#include "main.h"
+#include "nfc.h"
+#include "pn532_emulator.h"
+#include "sim.h"
+#include "tagcache.h"
+
+void setup();
+void loop();
+
+namespace {
+
+const uint8_t CONTROLS = 12;
+const uint32_t LAPS = 10;
+const uint32_t PHASE_MS = 600;           // Poll interval plus loop delay
+const uint32_t GIVE_UP_MS = 4000;        // Runner leaves without a beep
+const uint32_t STEP_AWAY_MS = 2000;      // Between taps
+
+// Records when a polling attempt first saw the tag
+class TimedAntenna : public TapSchedule {
+ public:
+  NtagTag* tagInField(uint64_t nowUs) override {
+    NtagTag* tag = TapSchedule::tagInField(nowUs);
+    if (tag && !firstSeenUs) firstSeenUs = nowUs;
+    return tag;
+  }
+
+  uint64_t firstSeenUs = 0;
+};
+
+TimedAntenna antenna;
+Pn532Emulator pn532(&antenna);
+std::deque<NtagTag> controls;
+uint64_t toneUs = 0;
+
+void onTone(unsigned int, unsigned long) {
+  if (!toneUs) toneUs = simMicros();
+}
+
+struct Stats {
+  uint32_t taps = 0;
+  uint64_t inFieldUs = 0;     // Detection until beep
+  uint64_t latencyUs = 0;     // Tag arrival until beep
+  uint32_t exchanges = 0;
+};
+
+void tap(NtagTag* tag, Stats* stats) {
+  uint64_t arrival = simMicros() + (uint64_t)(rand() % (PHASE_MS * 1000));
+  antenna.clear();
+  antenna.add(tag, arrival, (uint64_t)GIVE_UP_MS * 1000);
+  antenna.firstSeenUs = 0;
+  toneUs = 0;
+  uint32_t exchanges = pn532.stats().rfExchanges;
+
+  while (!toneUs && simMicros() < arrival + (uint64_t)GIVE_UP_MS * 1000) {
+    loop();
+  }
+  antenna.clear();
+
+  if (stats && toneUs) {
+    stats->taps++;
+    stats->inFieldUs += toneUs - antenna.firstSeenUs;
+    stats->latencyUs += toneUs - arrival;
+    stats->exchanges += pn532.stats().rfExchanges - exchanges;
+  }
+  delay(STEP_AWAY_MS);
+}
+
+// A whole run: start tag, the controls, the finish tag
+void session(NtagTag* start, NtagTag* finish, Stats* stats) {
+  tap(start, nullptr);
+  for (NtagTag& control : controls) {
+    tap(&control, stats);
+  }
+  tap(finish, nullptr);
+}
+
+// Start tag "KOR00/12", optionally followed by the course manifest record
+void formatStartTag(NtagTag& tag, bool withManifest) {
+  uint8_t message[160];
+  uint16_t n = 0;
+  const char* text = "KOR00/12";
+  message[n++] = withManifest ? 0x91 : 0xD1;  // ME only on the last record
+  message[n++] = 0x01;
+  message[n++] = 3 + strlen(text);
+  message[n++] = 'T';
+  message[n++] = 0x02;
+  message[n++] = 'e';
+  message[n++] = 'n';
+  memcpy(message + n, text, strlen(text));
+  n += strlen(text);
+
+  if (withManifest) {
+    const char* type = MANIFEST_RECORD_TYPE;
+    message[n++] = 0x54;  // ME, SR, TNF=4 (external)
+    message[n++] = strlen(type);
+    message[n++] = CONTROLS * 8;
+    memcpy(message + n, type, strlen(type));
+    n += strlen(type);
+    for (uint8_t c = 0; c < CONTROLS; c++) {
+      message[n++] = c + 1;
+      memcpy(message + n, controls[c].uid(), 7);
+      n += 7;
+    }
+  }
+  tag.formatNdef(message, n);
+}
+
+void report(const char* name, const Stats& stats) {
+  printf("%-28s %6.1f ms in field  %6.1f ms tap to beep  %5.1f tag commands  (%u taps)\n", name,
+         stats.inFieldUs / 1000.0 / stats.taps, stats.latencyUs / 1000.0 / stats.taps,
+         (double)stats.exchanges / stats.taps, stats.taps);
+}
+
+}  // namespace
+
+int main() {
+  Serial.setMuted(true);
+  srand(1);
+
+  simAttachPn532(PN532_SS, &pn532);
+  setup();
+  simSetToneHook(onTone);
+
+  for (uint8_t c = 0; c < CONTROLS; c++) {
+    controls.emplace_back(NTAG213, 1000 + c);
+    char text[6];
+    snprintf(text, sizeof(text), "KOR%02u", c + 1);
+    controls.back().formatText(text);
+  }
+  NtagTag start(NTAG213, 1);
+  NtagTag startWithManifest(NTAG213, 2);
+  NtagTag finish(NTAG213, 3);
+  formatStartTag(start, false);
+  formatStartTag(startWithManifest, true);
+  finish.formatText("KOR99");
+
+  Stats cold, warm, manifest, rebooted;
+  for (uint32_t l = 0; l < LAPS; l++) {
+    // A station that has not seen this course yet
+    clearTagCache();
+    session(&start, &finish, &cold);
+    session(&start, &finish, &warm);
+
+    session(&startWithManifest, &finish, &manifest);
+
+    // Power cycle: loadTagCache() drops what is in RAM and reads the flash copy
+    loadTagCache();
+    session(&start, &finish, &rebooted);
+  }
+
+  report("Unknown tags", cold);
+  report("Known tags (second run)", warm);
+  report("Preloaded from manifest", manifest);
+  report("After power cycle", rebooted);
+  return 0;
+}
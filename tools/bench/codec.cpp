@@ -0,0 +1,169 @@
+// base64url decoder throughput: scalar against the SSSE3 and AVX2 paths in
+// lib/korcodec, on readout payloads as the firmware writes them (one per
+// runner, 25-540 characters) and on one long buffer. Also times the whole
+// per-dump pipeline kor-decode runs (decode, parse, sequence check and
+// splits). Every path's output is checked against the scalar decoder, and
+// sipHash24(), which every readout MAC depends on, against the reference
+// vectors of the SipHash paper before anything is timed.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "press_table.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const unsigned DUMPS = 20000;
+const size_t LONG_BUFFER = 16 << 20;
+const double MIN_SECONDS = 0.5;
+
+// SipHash-2-4 of the messages 00, 00 01, ..., 00 01 .. 3e (lengths 0-63)
+// under the key 00 01 .. 0f, from the reference implementation's vectors.h
+const uint64_t SIPHASH_VECTORS[64] = {
+  0x726fdb47dd0e0e31ULL, 0x74f839c593dc67fdULL, 0x0d6c8009d9a94f5aULL, 0x85676696d7fb7e2dULL,
+  0xcf2794e0277187b7ULL, 0x18765564cd99a68dULL, 0xcbc9466e58fee3ceULL, 0xab0200f58b01d137ULL,
+  0x93f5f5799a932462ULL, 0x9e0082df0ba9e4b0ULL, 0x7a5dbbc594ddb9f3ULL, 0xf4b32f46226bada7ULL,
+  0x751e8fbc860ee5fbULL, 0x14ea5627c0843d90ULL, 0xf723ca908e7af2eeULL, 0xa129ca6149be45e5ULL,
+  0x3f2acc7f57c29bdbULL, 0x699ae9f52cbe4794ULL, 0x4bc1b3f0968dd39cULL, 0xbb6dc91da77961bdULL,
+  0xbed65cf21aa2ee98ULL, 0xd0f2cbb02e3b67c7ULL, 0x93536795e3a33e88ULL, 0xa80c038ccd5ccec8ULL,
+  0xb8ad50c6f649af94ULL, 0xbce192de8a85b8eaULL, 0x17d835b85bbb15f3ULL, 0x2f2e6163076bcfadULL,
+  0xde4daaaca71dc9a5ULL, 0xa6a2506687956571ULL, 0xad87a3535c49ef28ULL, 0x32d892fad841c342ULL,
+  0x7127512f72f27cceULL, 0xa7f32346f95978e3ULL, 0x12e0b01abb051238ULL, 0x15e034d40fa197aeULL,
+  0x314dffbe0815a3b4ULL, 0x027990f029623981ULL, 0xcadcd4e59ef40c4dULL, 0x9abfd8766a33735cULL,
+  0x0e3ea96b5304a7d0ULL, 0xad0c42d6fc585992ULL, 0x187306c89bc215a9ULL, 0xd4a60abcf3792b95ULL,
+  0xf935451de4f21df2ULL, 0xa9538f0419755787ULL, 0xdb9acddff56ca510ULL, 0xd06c98cd5c0975ebULL,
+  0xe612a3cb9ecba951ULL, 0xc766e62cfcadaf96ULL, 0xee64435a9752fe72ULL, 0xa192d576b245165aULL,
+  0x0a8787bf8ecb74b2ULL, 0x81b3e73d20b49b6fULL, 0x7fa8220ba3b2eceaULL, 0x245731c13ca42499ULL,
+  0xb78dbfaf3a8d83bdULL, 0xea1ad565322a1a0bULL, 0x60e61c23a3795013ULL, 0x6606d7e446282b93ULL,
+  0x6ca4ecb15c5f91e1ULL, 0x9f626da15c9625f3ULL, 0xe51b38608ef25f57ULL, 0x958a324ceb064572ULL,
+};
+
+bool sipHashMatchesReference() {
+  uint8_t key[kor::MAC_KEY_SIZE];
+  uint8_t message[64];
+  for (uint8_t i = 0; i < sizeof(key); i++) key[i] = i;
+  for (uint8_t i = 0; i < sizeof(message); i++) message[i] = i;
+  for (size_t length = 0; length < 64; length++) {
+    if (kor::sipHash24(key, message, length) != SIPHASH_VECTORS[length]) {
+      printf("sipHash24 differs from the reference for a %zu byte message\n", length);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Start, controls with the occasional mispunch, finish; up to the firmware's
+// 100 presses
+std::string syntheticPayload(std::mt19937& rng) {
+  std::uniform_int_distribution<int> courseLength(5, 40);
+  std::uniform_int_distribution<uint32_t> leg(30000, 400000);
+  std::uniform_int_distribution<int> chance(0, 99);
+
+  kor::PressTable table;
+  table.courseLength = courseLength(rng);
+  table.presses.push_back({kor::START_CHECKPOINT, 0});
+  uint32_t time = 0;
+  for (uint8_t control = 1; control <= table.courseLength; control++) {
+    if (chance(rng) < 5) table.presses.push_back({(uint8_t)(control + 1), time += leg(rng)});
+    table.presses.push_back({control, time += leg(rng)});
+  }
+  if (chance(rng) < 90) table.presses.push_back({kor::FINISH_CHECKPOINT, time += leg(rng)});
+  return kor::encodePressTable(table);
+}
+
+// Runs `pass` until MIN_SECONDS have passed; returns seconds per pass
+template <typename Pass>
+double timePasses(Pass pass) {
+  unsigned passes = 0;
+  Clock::time_point start = Clock::now();
+  double elapsed = 0;
+  while (elapsed < MIN_SECONDS) {
+    pass();
+    passes++;
+    elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  }
+  return elapsed / passes;
+}
+
+}  // namespace
+
+int main() {
+  if (!sipHashMatchesReference()) return 1;
+  printf("sipHash24 matches the 64 SipHash-2-4 reference vectors\n");
+
+  std::mt19937 rng(1);
+  std::vector<std::string> payloads;
+  size_t payloadBytes = 0;
+  for (unsigned i = 0; i < DUMPS; i++) {
+    payloads.push_back(syntheticPayload(rng));
+    payloadBytes += payloads.back().size();
+  }
+
+  std::string longText;
+  std::uniform_int_distribution<int> sextet(0, 63);
+  for (size_t i = 0; i < LONG_BUFFER; i++) longText += kor::BASE64URL_CHARS[sextet(rng)];
+
+  std::vector<uint8_t> reference(kor::base64UrlDecodedLength(longText.size()));
+  kor::base64UrlDecodeScalar(longText.data(), longText.size(), reference.data());
+  std::vector<std::vector<uint8_t>> referenceDumps(DUMPS);
+  for (unsigned i = 0; i < DUMPS; i++) kor::base64UrlDecode(payloads[i], referenceDumps[i], kor::Base64Impl::Scalar);
+
+  printf("%u dumps, %.1f characters on average; long buffer %zu MB\n", DUMPS, (double)payloadBytes / DUMPS,
+         LONG_BUFFER >> 20);
+  printf("%-8s %14s %14s %16s\n", "decoder", "dumps MB/s", "long MB/s", "pipeline dumps/s");
+
+  double scalarDumps = 0;
+  double scalarLong = 0;
+  for (kor::Base64Impl impl : {kor::Base64Impl::Scalar, kor::Base64Impl::Sse, kor::Base64Impl::Avx2}) {
+    if (!kor::base64ImplSupported(impl)) {
+      printf("%-8s not supported on this CPU\n", kor::base64ImplName(impl));
+      continue;
+    }
+
+    std::vector<uint8_t> out(reference.size());
+    bool ok = kor::base64UrlDecode(longText.data(), longText.size(), out.data(), impl) && out == reference;
+    std::vector<uint8_t> dump;
+    for (unsigned i = 0; i < DUMPS && ok; i++) {
+      ok = kor::base64UrlDecode(payloads[i], dump, impl) && dump == referenceDumps[i];
+    }
+    if (!ok) {
+      printf("%-8s output differs from the scalar decoder\n", kor::base64ImplName(impl));
+      return 1;
+    }
+
+    uint8_t buffer[512];
+    double dumpsSeconds = timePasses([&]() {
+      for (const std::string& payload : payloads) {
+        kor::base64UrlDecode(payload.data(), payload.size(), buffer, impl);
+      }
+    });
+    double longSeconds = timePasses([&]() {
+      kor::base64UrlDecode(longText.data(), longText.size(), out.data(), impl);
+    });
+
+    size_t statuses[3] = {0, 0, 0};
+    kor::PressTable table;
+    double pipelineSeconds = timePasses([&]() {
+      for (const std::string& payload : payloads) {
+        kor::base64UrlDecode(payload, dump, impl);
+        kor::parsePressTable(dump.data(), dump.size(), table);
+        statuses[(int)kor::analysePressTable(table).status]++;
+      }
+    });
+
+    double dumpsRate = payloadBytes / dumpsSeconds / 1e6;
+    double longRate = longText.size() / longSeconds / 1e6;
+    if (impl == kor::Base64Impl::Scalar) {
+      scalarDumps = dumpsRate;
+      scalarLong = longRate;
+    }
+    printf("%-8s %8.0f (%3.1fx) %8.0f (%3.1fx) %16.0f\n", kor::base64ImplName(impl), dumpsRate,
+           dumpsRate / scalarDumps, longRate, longRate / scalarLong, DUMPS / pipelineSeconds);
+  }
+  return 0;
+}
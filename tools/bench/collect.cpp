@@ -0,0 +1,192 @@
+// Finish-tent collector: the real firmware (src/), built in collector mode,
+// reads back the readout tags of a peak-hour queue of runners against an
+// emulated PN532. Each runner puts their tag on the antenna, takes it off
+// after the beep and hands over to the next one. Some runners tap a second
+// time a little later, some tags carry a tampered MAC. Prints runners per
+// minute and the tap-to-beep time, then checks the "collect dump" output:
+// every run once, decoded and verified the way kor-decode does it.
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "collector.h"
+#include "nfc.h"
+#include "pn532_emulator.h"
+#include "press_table.h"
+#include "serialize.h"
+#include "sim.h"
+
+void setup();
+void loop();
+
+namespace {
+
+const uint16_t RUNNERS = 120;
+const uint8_t COURSE_LENGTH = 7;
+const uint16_t RETAP_EVERY = 10;         // Every 10th runner is unsure and taps again
+const uint16_t RETAP_AFTER = 3;          // ... three runners later
+const uint16_t TAMPER_EVERY = 20;        // Every 20th tag carries a MAC that does not match
+const uint32_t REACTION_MS = 200;        // Runner takes the tag off after the beep
+const uint32_t HANDOVER_MS = 900;        // Next runner steps up and places their tag
+const uint32_t GIVE_UP_MS = 5000;
+const unsigned int SUCCESS_FREQUENCY = 1500;  // playSuccessTone()
+const uint8_t macKey[kor::MAC_KEY_SIZE] = READOUT_MAC_KEY;
+
+struct Runner {
+  NtagTag tag;
+  kor::PressTable table;
+  std::string payload;
+  bool tampered;
+};
+
+TapSchedule antenna;
+Pn532Emulator pn532(&antenna);
+std::deque<Runner> runners;
+uint64_t beepUs = 0;
+unsigned int beepFrequency = 0;
+
+void onTone(unsigned int frequency, unsigned long) {
+  if (!beepUs) {
+    beepUs = simMicros();
+    beepFrequency = frequency;
+  }
+}
+
+void runFor(uint64_t us) {
+  uint64_t end = simMicros() + us;
+  while (simMicros() < end) {
+    loop();
+  }
+}
+
+// Start, the course in order and the finish, with made-up splits
+void makeRunner(uint16_t index) {
+  runners.push_back({ NtagTag(NTAG213, 7000 + index), {}, {}, index % TAMPER_EVERY == TAMPER_EVERY - 1 });
+  Runner& runner = runners.back();
+  runner.table.courseLength = COURSE_LENGTH;
+  uint32_t time = 0;
+  for (uint8_t checkpoint = 0; checkpoint <= COURSE_LENGTH + 1; checkpoint++) {
+    uint8_t id = checkpoint > COURSE_LENGTH ? kor::FINISH_CHECKPOINT : checkpoint;
+    runner.table.presses.push_back({ id, time });
+    time += 180000 + (index * 7919 + checkpoint * 104729) % 240000;
+  }
+  runner.payload = kor::encodePressTable(runner.table);
+
+  std::vector<uint8_t> binary;
+  kor::base64UrlDecode(runner.payload, binary);
+  char mac[kor::MAC_TEXT_LENGTH + 1] = {};
+  kor::macText(kor::pressTableMac(macKey, binary.data(), binary.size()), mac);
+  if (runner.tampered) mac[0] = mac[0] == 'A' ? 'B' : 'A';
+
+  std::string uri = std::string(READOUT_URL_PREFIX) + runner.payload + KOR_MAC_PARAM + mac;
+  runner.tag.formatUri(0x04, uri.c_str());
+}
+
+struct Tap {
+  uint16_t runner;
+  bool repeat;
+};
+
+}  // namespace
+
+int main() {
+  simAttachPn532(PN532_SS, &pn532);
+  Serial.setMuted(true);
+  setup();
+  Serial.inject("collect clear\n");
+  runFor(200000);
+  simSetToneHook(onTone);
+
+  std::vector<Tap> queue;
+  for (uint16_t i = 0; i < RUNNERS; i++) {
+    makeRunner(i);
+    queue.push_back({ i, false });
+    if (i >= RETAP_AFTER && (i - RETAP_AFTER) % RETAP_EVERY == RETAP_EVERY - 1) {
+      queue.push_back({ (uint16_t)(i - RETAP_AFTER), true });
+    }
+  }
+
+  std::vector<double> beepMs;
+  uint32_t missed = 0;
+  uint32_t wrongBeep = 0;
+  uint64_t started = simMicros();
+  for (const Tap& tap : queue) {
+    Runner& runner = runners[tap.runner];
+    beepUs = 0;
+    uint64_t placed = simMicros();
+    antenna.clear();
+    antenna.add(&runner.tag, placed, (uint64_t)GIVE_UP_MS * 1000);
+    while (!beepUs && simMicros() < placed + (uint64_t)GIVE_UP_MS * 1000) {
+      loop();
+    }
+    if (!beepUs) {
+      missed++;
+    } else {
+      beepMs.push_back((beepUs - placed) / 1000.0);
+      // A repeat tap of a tampered tag is only deduplicated, which beeps
+      bool expectSuccess = !runner.tampered || tap.repeat;
+      if ((beepFrequency == SUCCESS_FREQUENCY) != expectSuccess) wrongBeep++;
+    }
+
+    runFor((uint64_t)REACTION_MS * 1000);
+    antenna.clear();
+    runFor((uint64_t)HANDOVER_MS * 1000);
+  }
+  double minutes = (simMicros() - started) / 60e6;
+  simSetToneHook(nullptr);
+
+  std::sort(beepMs.begin(), beepMs.end());
+  double p50 = beepMs.empty() ? 0 : beepMs[(beepMs.size() - 1) / 2];
+  double p95 = beepMs.empty() ? 0 : beepMs[(beepMs.size() - 1) * 95 / 100];
+  printf("%zu taps by %u runners in %.1f min: %.1f runners/min, tap to beep p50 %.0f ms, p95 %.0f ms, "
+         "%u without a beep, %u wrong beeps\n",
+         queue.size(), RUNNERS, minutes, RUNNERS / minutes, p50, p95, missed, wrongBeep);
+
+  // Read the table back the way an organiser does after the race
+  std::string dump;
+  Serial.setCapture(&dump);
+  Serial.inject("collect dump\n");
+  runFor(200000);
+  Serial.setCapture(nullptr);
+
+  std::vector<bool> seen(RUNNERS, false);
+  uint32_t lines = 0, duplicates = 0, unknown = 0, macWrong = 0;
+  size_t start = 0;
+  while (start < dump.size()) {
+    size_t end = dump.find('\n', start);
+    if (end == std::string::npos) end = dump.size();
+    std::string line = dump.substr(start, end - start);
+    start = end + 1;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.compare(0, 8, "https://") != 0) continue;
+    lines++;
+
+    std::string_view payload = kor::extractTablePayload(line);
+    auto match = std::find_if(runners.begin(), runners.end(), [&](const Runner& r) { return r.payload == payload; });
+    if (match == runners.end()) {
+      unknown++;
+      continue;
+    }
+    size_t index = match - runners.begin();
+    if (seen[index]) duplicates++;
+    seen[index] = true;
+
+    std::vector<uint8_t> binary;
+    kor::base64UrlDecode(payload, binary);
+    kor::MacStatus status = kor::verifyPressTableMac(macKey, binary.data(), binary.size(), kor::extractMacParam(line));
+    if (status != (match->tampered ? kor::MacStatus::Invalid : kor::MacStatus::Valid)) macWrong++;
+  }
+  uint32_t absent = std::count(seen.begin(), seen.end(), false);
+  printf("collect dump: %u runs (%u stored), %zu bytes, %.1f s on the serial line at 115200 baud; "
+         "%u missing, %u duplicated, %u unknown, %u with a wrong MAC status\n",
+         lines, collectedRunCount(), dump.size(), dump.size() * 10 / 115200.0, absent, duplicates, unknown, macWrong);
+
+  bool ok = missed == 0 && wrongBeep == 0 && lines == RUNNERS && absent == 0 && duplicates == 0 && unknown == 0 &&
+            macWrong == 0;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// Tap duration sweep: a tag is held on the antenna for a fixed dwell time,
+// arriving at a random point of the polling cycle, while the real firmware
+// (src/) talks to an emulated PN532 over SPI. Reports for each dwell time how
+// often a control tap registers and how often a readout ends with an intact
+// tag, including readouts the station beeped OK for while the tag was left
+// torn. Control taps are also run as two short touches, the second one
+// finishing an interrupted read. Prints the shortest dwell from which every
+// trial succeeded.
+
+#include <Arduino.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+#include "history.h"
+#include "main.h"
+#include "melodies.h"
+#include "nfc.h"
+#include "pn532_emulator.h"
+#include "serialize.h"
+#include "sim.h"
+
+void setup();
+void loop();
+void startNewSession();
+
+namespace {
+
+const uint32_t TRIALS = 100;
+const uint32_t SETTLE_MS = 2500;            // After the tag leaves, let melodies finish
+const uint32_t PHASE_MS = 600;              // Poll interval plus loop delay
+const uint32_t RETAP_MS = 300;              // Runner hears the cue and taps again
+const uint8_t READOUT_PRESSES = 40;         // Enough presses to fill most of the readout pages
+
+TapSchedule antenna;
+Pn532Emulator pn532(&antenna);
+std::deque<NtagTag> tags;
+uint32_t nextSerial = 1;
+
+bool heardOk = false;
+bool heardError = false;
+
+void onTone(unsigned int frequency, unsigned long) {
+  if (frequency == (unsigned int)READOUT_END_MELODY[0].frequency) heardOk = true;
+  if (frequency == (unsigned int)ERROR_MELODY[0].frequency) heardError = true;
+}
+
+// Hold `tag` on the antenna for `dwellMs`, starting at a random point of the
+// poll cycle, `touches` times with RETAP_MS in between
+void tap(NtagTag* tag, uint32_t dwellMs, uint8_t touches = 1) {
+  heardOk = false;
+  heardError = false;
+
+  uint64_t arrival = simMicros() + (uint64_t)(rand() % (PHASE_MS * 1000));
+  antenna.clear();
+  for (uint8_t t = 0; t < touches; t++) {
+    antenna.add(tag, arrival + (uint64_t)t * (dwellMs + RETAP_MS) * 1000, (uint64_t)dwellMs * 1000);
+  }
+
+  uint64_t end = arrival + ((uint64_t)touches * (dwellMs + RETAP_MS) + SETTLE_MS) * 1000;
+  while (simMicros() < end) {
+    loop();
+  }
+  antenna.clear();
+}
+
+struct Outcome {
+  uint32_t ok = 0;
+  uint32_t failed = 0;    // Error melody: the runner knows to tap again
+  uint32_t missed = 0;    // No reaction at all
+  uint32_t silent = 0;    // OK melody but the tag content is wrong
+};
+
+Outcome controlTaps(uint32_t dwellMs, uint8_t touches) {
+  Outcome outcome;
+  for (uint32_t t = 0; t < TRIALS; t++) {
+    startNewSession();
+    tags.emplace_back(NTAG213, nextSerial++);
+    tags.back().formatText("KOR01");
+
+    tap(&tags.back(), dwellMs, touches);
+    if (historySession(0)->pressCount > 0) {
+      outcome.ok++;
+    } else if (heardError) {
+      outcome.failed++;
+    } else {
+      outcome.missed++;
+    }
+  }
+  return outcome;
+}
+
+Outcome singleTaps(uint32_t dwellMs) {
+  return controlTaps(dwellMs, 1);
+}
+
+// Glancing taps: the second touch continues the read where the first stopped
+Outcome doubleTaps(uint32_t dwellMs) {
+  return controlTaps(dwellMs, 2);
+}
+
+Outcome readoutTaps(uint32_t dwellMs) {
+  uint16_t imageLength;
+  const uint8_t* image = readoutNdefImage(&imageLength);
+
+  Outcome outcome;
+  for (uint32_t t = 0; t < TRIALS; t++) {
+    // Fresh UID, so every readout writes the whole image
+    tags.emplace_back(NTAG213, nextSerial++);
+    NtagTag& tag = tags.back();
+    tag.formatUri(READOUT_URI_CODE, "kor.swarm.ostuda.net/dump.html");
+
+    tap(&tag, dwellMs);
+    bool intact = memcmp(tag.page(READOUT_FIRST_PAGE), image, imageLength) == 0;
+    if (heardOk && intact) {
+      outcome.ok++;
+    } else if (heardOk) {
+      outcome.silent++;
+    } else if (heardError) {
+      outcome.failed++;
+    } else {
+      outcome.missed++;
+    }
+  }
+  return outcome;
+}
+
+void printRow(uint32_t dwellMs, const Outcome& outcome, bool showSilent) {
+  printf("%6u ms  %5.1f%% ok  %5.1f%% error beep  %5.1f%% missed", dwellMs, 100.0 * outcome.ok / TRIALS,
+         100.0 * outcome.failed / TRIALS, 100.0 * outcome.missed / TRIALS);
+  if (showSilent) printf("  %5.1f%% OK beep on a torn tag", 100.0 * outcome.silent / TRIALS);
+  printf("\n");
+}
+
+// Shortest dwell from which every longer dwell in the sweep also succeeded
+uint32_t reliableDwell(const std::vector<std::pair<uint32_t, Outcome>>& rows) {
+  uint32_t reliable = 0;
+  for (auto it = rows.rbegin(); it != rows.rend() && it->second.ok == TRIALS; ++it) {
+    reliable = it->first;
+  }
+  return reliable;
+}
+
+void sweep(const char* title, uint32_t fromMs, uint32_t toMs, uint32_t stepMs, Outcome (*run)(uint32_t),
+           bool showSilent) {
+  printf("%s (%u trials per dwell)\n", title, TRIALS);
+  std::vector<std::pair<uint32_t, Outcome>> rows;
+  for (uint32_t dwell = fromMs; dwell <= toMs; dwell += stepMs) {
+    rows.push_back({dwell, run(dwell)});
+    printRow(dwell, rows.back().second, showSilent);
+  }
+
+  uint32_t reliable = reliableDwell(rows);
+  if (reliable) {
+    printf("100%% success from %u ms\n\n", reliable);
+  } else {
+    printf("no dwell in the sweep reached 100%% success\n\n");
+  }
+}
+
+}  // namespace
+
+int main() {
+  Serial.setMuted(true);
+  srand(1);
+
+  simAttachPn532(PN532_SS, &pn532);
+  setup();
+  simSetToneHook(onTone);
+
+  processCheckpoint(0, 98, 0);
+  sweep("Control tap", 50, 1000, 50, singleTaps, false);
+  sweep("Control tap, two touches", 50, 1000, 50, doubleTaps, false);
+
+  // Readouts write the payload of a partly run course
+  startNewSession();
+  for (uint8_t i = 1; i < READOUT_PRESSES; i++) {
+    delay(60000);
+    processCheckpoint(i, 0, 0);
+  }
+  sweep("Readout", 250, 3000, 250, readoutTaps, true);
+
+  const Pn532Stats& stats = pn532.stats();
+  printf("PN532: %u frames, %u aborted, %u RF exchanges, %u failed, %u torn writes\n", stats.frames, stats.aborts,
+         stats.rfExchanges, stats.rfFailures, stats.tornWrites);
+  return 0;
+}
@@ -0,0 +1,93 @@
+// Provisioning throughput: an operator prepares a 40-control course with the
+// real firmware (src/) in provisioning mode, started from the serial console,
+// against an emulated PN532. Each blank tag is placed on the antenna and
+// taken off after the success beep. Prints the firmware's per-tag timing log
+// and the total time, then checks every tag: content, read-only CC and lock
+// bits.
+
+#include <Arduino.h>
+
+#include <cstdio>
+#include <deque>
+
+#include "main.h"
+#include "nfc.h"
+#include "pn532_emulator.h"
+#include "sim.h"
+
+void setup();
+void loop();
+
+namespace {
+
+const uint8_t CONTROLS = 40;
+const uint32_t HANDLING_MS = 1000;      // Put the last tag away, pick up the next one
+const uint32_t REACTION_MS = 200;       // Operator takes the tag off after the beep
+const uint32_t GIVE_UP_MS = 5000;
+const unsigned int SUCCESS_FREQUENCY = 1500;  // playSuccessTone()
+
+TapSchedule antenna;
+Pn532Emulator pn532(&antenna);
+std::deque<NtagTag> tags;
+uint64_t beepUs = 0;
+
+void onTone(unsigned int frequency, unsigned long) {
+  if (frequency == SUCCESS_FREQUENCY && !beepUs) beepUs = simMicros();
+}
+
+void runFor(uint64_t us) {
+  uint64_t end = simMicros() + us;
+  while (simMicros() < end) {
+    loop();
+  }
+}
+
+}  // namespace
+
+int main() {
+  simAttachPn532(PN532_SS, &pn532);
+  setup();
+  simSetToneHook(onTone);
+
+  Serial.inject("prov controls 1 40 lock\n");
+  runFor(200000);
+
+  uint64_t started = simMicros();
+  uint32_t failures = 0;
+  for (uint8_t c = 0; c < CONTROLS; c++) {
+    tags.emplace_back(NTAG213, 5000 + c);
+    NtagTag* tag = &tags.back();
+
+    beepUs = 0;
+    uint64_t placed = simMicros();
+    antenna.clear();
+    antenna.add(tag, placed, (uint64_t)GIVE_UP_MS * 1000);
+    while (!beepUs && simMicros() < placed + (uint64_t)GIVE_UP_MS * 1000) {
+      loop();
+    }
+    if (!beepUs) failures++;
+
+    runFor((uint64_t)REACTION_MS * 1000);
+    antenna.clear();
+    runFor((uint64_t)HANDLING_MS * 1000);
+  }
+  double minutes = (simMicros() - started) / 60e6;
+
+  Serial.inject("manifest\n");
+  runFor(200000);
+
+  // Check what ended up on the tags
+  uint8_t wrong = 0;
+  for (uint8_t c = 0; c < CONTROLS; c++) {
+    NtagTag& tag = tags[c];
+    char text[6];
+    snprintf(text, sizeof(text), "KOR%02u", c + 1);
+    bool content = memcmp(tag.page(4) + 9, text, 5) == 0;
+    bool readOnly = tag.page(3)[3] == 0x0F && tag.isPageLocked(4) && tag.isPageLocked(39);
+    if (!content || !readOnly) wrong++;
+  }
+
+  printf("%u controls provisioned and locked in %.1f min (%.1f tags/min), %u not confirmed, %u wrong\n", CONTROLS,
+         minutes, CONTROLS / minutes, failures, wrong);
+  return wrong == 0 && failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+// RF diagnostics: the real firmware (src/) runs its rfdiag console command
+// against an emulated PN532 with a tag held on the antenna, once for a good
+// mount and then for mounts that lose the tag for short fades (metal behind
+// the tag, a wet post). Prints the firmware's report for each mount, so the
+// table can be compared with one taken on the real station.
+
+#include <Arduino.h>
+
+#include <cstdio>
+
+#include "nfc.h"
+#include "pn532_emulator.h"
+#include "rfdiag.h"
+#include "sim.h"
+
+void setup();
+void loop();
+
+namespace {
+
+const uint16_t CYCLES = 200;
+const uint64_t FADE_SLOT_US = 10000;  // Coupling is good or lost for 10 ms at a time
+
+// The tag sits on the antenna; each FADE_SLOT_US slot is lost with the given
+// probability, decided by a hash of the slot so runs are repeatable
+class FadingAntenna : public SimAntenna {
+ public:
+  FadingAntenna(NtagTag* tag, uint16_t fadePermille) : tag_(tag), fadePermille_(fadePermille) {}
+
+  NtagTag* tagInField(uint64_t nowUs) override { return faded(nowUs / FADE_SLOT_US) ? nullptr : tag_; }
+
+  bool presentThroughout(NtagTag* tag, uint64_t fromUs, uint64_t toUs) override {
+    if (tag != tag_) return false;
+    for (uint64_t slot = fromUs / FADE_SLOT_US; slot <= toUs / FADE_SLOT_US; slot++) {
+      if (faded(slot)) return false;
+    }
+    return true;
+  }
+
+ private:
+  bool faded(uint64_t slot) const {
+    uint64_t x = slot * 0x9E3779B97F4A7C15ULL;
+    x ^= x >> 29;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 32;
+    return x % 1000 < fadePermille_;
+  }
+
+  NtagTag* tag_;
+  uint16_t fadePermille_;
+};
+
+struct Mount {
+  const char* name;
+  uint16_t fadePermille;
+};
+
+const Mount MOUNTS[] = {
+  { "good mount", 0 },
+  { "marginal mount, 1% fades", 10 },
+  { "poor mount, 5% fades", 50 },
+};
+
+Pn532Emulator pn532;
+
+}  // namespace
+
+int main() {
+  simAttachPn532(PN532_SS, &pn532);
+  setup();
+
+  NtagTag tag(NTAG213, 1);
+  bool goodMountClean = false;
+  for (const Mount& mount : MOUNTS) {
+    FadingAntenna antenna(&tag, mount.fadePermille);
+    pn532.setAntenna(&antenna);
+    printf("\n== %s ==\n", mount.name);
+    fflush(stdout);
+
+    char command[32];
+    snprintf(command, sizeof(command), "rfdiag %u\n", CYCLES);
+    Serial.inject(command);
+    uint64_t started = simMicros();
+    do {
+      loop();
+    } while (isRfDiagRunning());
+    printf("%u cycles in %.1f s\n", CYCLES, (simMicros() - started) / 1e6);
+
+    if (mount.fadePermille == 0) {
+      const RfDiagReport& report = rfDiagReport();
+      goodMountClean = report.noTag == 0;
+      for (uint8_t op = 0; op < RF_DIAG_OPS; op++) {
+        if (report.ops[op].failed > 0 || report.ops[op].retries > 0) goodMountClean = false;
+      }
+    }
+    pn532.setAntenna(nullptr);
+  }
+  return goodMountClean ? 0 : 1;
+}
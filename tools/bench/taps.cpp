@@ -0,0 +1,123 @@
+// Simulated mass-start load on one station: runners queue at each antenna,
+// hold their tag until the station beeps, step away and the next runner steps
+// up. Runs the real firmware (src/) against emulated PN532s and reports
+// taps per minute. Built once per reader configuration, see tools/Makefile.
+
+#include <Arduino.h>
+
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+#include "main.h"
+#include "nfc.h"
+#include "pn532_emulator.h"
+#include "sim.h"
+
+void setup();
+void loop();
+
+namespace {
+
+const uint32_t STEP_UP_MS = 1200;       // Next runner reaches the antenna
+const uint32_t REACTION_MS = 200;       // Runner pulls the tag after the beep
+const uint32_t GIVE_UP_MS = 4000;       // Runner leaves without a beep
+const uint32_t DURATION_MS = 10 * 60 * 1000;
+const uint8_t COURSE_LENGTH = 98;
+
+uint32_t runnersServed = 0;
+uint32_t completedTaps = 0;
+uint32_t failedTaps = 0;
+
+class RunnerQueue : public SimAntenna {
+ public:
+  explicit RunnerQueue(uint8_t reader) : reader_(reader) {}
+
+  NtagTag* tagInField(uint64_t nowUs) override {
+    if (!present_ && nowUs >= nextArrival_) {
+      runnersServed++;
+      tags_.emplace_back(NTAG213, runnersServed);
+      tags_.back().formatText(checkpointText(runnersServed));
+      present_ = true;
+      acknowledged_ = false;
+      arrivedAt_ = nextArrival_;
+      leaveAt_ = arrivedAt_ + GIVE_UP_MS * 1000ULL;
+    }
+    if (present_ && nowUs >= leaveAt_) {
+      if (acknowledged_) {
+        completedTaps++;
+      } else {
+        failedTaps++;
+      }
+      present_ = false;
+      nextArrival_ = leaveAt_ + STEP_UP_MS * 1000ULL;
+      return tagInField(nowUs);
+    }
+    return present_ && nowUs >= arrivedAt_ ? &tags_.back() : nullptr;
+  }
+
+  bool presentThroughout(NtagTag* tag, uint64_t fromUs, uint64_t toUs) override {
+    return present_ && tag == &tags_.back() && fromUs >= arrivedAt_ && toUs < leaveAt_;
+  }
+
+  // The station beeped: if it read this runner's tag, the runner steps away
+  void beep(uint64_t nowUs) {
+    const NfcReader& reader = nfcReaders[reader_];
+    if (present_ && !acknowledged_ && memcmp(reader.uid, tags_.back().uid(), reader.uidLength) == 0) {
+      acknowledged_ = true;
+      leaveAt_ = nowUs + REACTION_MS * 1000ULL;
+    }
+  }
+
+ private:
+  static const char* checkpointText(uint32_t runner) {
+    static char text[6];
+    snprintf(text, sizeof(text), "KOR%02u", (unsigned)((runner - 1) % COURSE_LENGTH + 1));
+    return text;
+  }
+
+  uint8_t reader_;
+  std::deque<NtagTag> tags_;  // The emulated PN532 may still hold a pointer to a previous runner's tag
+  bool present_ = false;
+  bool acknowledged_ = false;
+  uint64_t arrivedAt_ = 0;
+  uint64_t leaveAt_ = 0;
+  uint64_t nextArrival_ = 0;
+};
+
+std::vector<RunnerQueue*> queues;
+
+void onTone(unsigned int, unsigned long) {
+  for (RunnerQueue* queue : queues) {
+    queue->beep(simMicros());
+  }
+}
+
+}  // namespace
+
+int main() {
+  Serial.setMuted(true);
+
+  const uint8_t pins[] = {PN532_SS, PN532_SS_2};
+  for (uint8_t r = 0; r < NFC_READER_COUNT; r++) {
+    queues.push_back(new RunnerQueue(r));
+    simAttachPn532(pins[r], new Pn532Emulator(queues.back()));
+  }
+  setup();
+
+  // Start the race directly so every tap is logged as a control
+  processCheckpoint(0, COURSE_LENGTH, 0);
+
+  simSetToneHook(onTone);
+
+  uint32_t start = millis();
+  while (millis() - start < DURATION_MS) {
+    loop();
+  }
+
+  double minutes = (millis() - start) / 60000.0;
+  printf("%u reader(s), %s: %.1f taps/min (%u taps, %u failed in %.1f min)\n", NFC_READER_COUNT,
+         NFC_POLL_MODE == NFC_POLL_ROUND_ROBIN ? "round-robin" : "interleaved", completedTaps / minutes,
+         completedTaps, failedTaps, minutes);
+  return 0;
+}
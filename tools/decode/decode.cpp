@@ -0,0 +1,204 @@
+// Offline readout decoder
+//
+//   kor-decode [--format csv|json] [--impl scalar|sse|avx2] [--mac-key HEX] [FILE]...
+//
+// Reads dump URLs (or bare payloads, or "table=..." queries), one per line,
+// from the files or stdin, and writes every press with its split and
+// sequence check: CSV (one row per press) or JSON (one object per dump).
+// Lines that do not decode are reported on stderr and skipped. With
+// --mac-key each dump's MAC is checked: valid, invalid or missing.
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "press_table.h"
+
+namespace {
+
+enum class Format {
+  Csv,
+  Json
+};
+
+struct Decoder {
+  Format format = Format::Csv;
+  kor::Base64Impl impl = kor::bestBase64Impl();
+  const uint8_t* macKey = nullptr;
+  size_t dumps = 0;
+  size_t invalid = 0;
+  size_t unverified = 0;  // MAC missing or wrong
+
+  std::vector<uint8_t> binary;
+  kor::PressTable table;
+  std::string out;
+
+  void begin() {
+    if (format == Format::Csv) {
+      out += "source,line,course_length,status,total_ms,visited,mac,press,checkpoint,timestamp_ms,split_ms,out_of_order\n";
+    } else {
+      out += "[";
+    }
+  }
+
+  void end() {
+    if (format == Format::Json) out += dumps ? "\n]\n" : "]\n";
+    flush();
+  }
+
+  void flush() {
+    fwrite(out.data(), 1, out.size(), stdout);
+    out.clear();
+  }
+
+  void decodeLine(const char* source, size_t lineNumber, std::string_view line) {
+    std::string_view payload = kor::extractTablePayload(line);
+    if (payload.empty() || payload[0] == '#') return;
+
+    if (!kor::base64UrlDecode(payload, binary, impl) || !kor::parsePressTable(binary.data(), binary.size(), table)) {
+      fprintf(stderr, "%s:%zu: not a readout payload\n", source, lineNumber);
+      invalid++;
+      return;
+    }
+    kor::Analysis analysis = kor::analysePressTable(table);
+    kor::MacStatus mac = kor::verifyPressTableMac(macKey, binary.data(), binary.size(), kor::extractMacParam(line));
+    if (mac == kor::MacStatus::Missing || mac == kor::MacStatus::Invalid) unverified++;
+
+    if (format == Format::Csv) {
+      appendCsv(source, lineNumber, analysis, mac);
+    } else {
+      appendJson(source, lineNumber, analysis, mac);
+    }
+    dumps++;
+    if (out.size() > (1 << 20)) flush();
+  }
+
+  void appendCsv(const char* source, size_t lineNumber, const kor::Analysis& analysis, kor::MacStatus mac) {
+    std::string prefix = std::string(source) + "," + std::to_string(lineNumber) + "," +
+                         std::to_string(table.courseLength) + "," + kor::raceStatusName(analysis.status) + "," +
+                         std::to_string(analysis.totalTime) + "," + std::to_string(analysis.visited) + "," +
+                         kor::macStatusName(mac) + ",";
+    for (size_t i = 0; i < table.presses.size(); i++) {
+      out += prefix;
+      out += std::to_string(i + 1) + "," + std::to_string(table.presses[i].checkpoint) + "," +
+             std::to_string(table.presses[i].timestamp) + ",";
+      if (analysis.splits[i] >= 0) out += std::to_string(analysis.splits[i]);
+      out += analysis.outOfOrder[i] ? ",1\n" : ",0\n";
+    }
+  }
+
+  void appendJson(const char* source, size_t lineNumber, const kor::Analysis& analysis, kor::MacStatus mac) {
+    out += dumps ? ",\n" : "\n";
+    out += "{\"source\":\"";
+    for (const char* c = source; *c; c++) {
+      if (*c == '"' || *c == '\\') out += '\\';
+      out += *c;
+    }
+    out += "\",\"line\":" + std::to_string(lineNumber);
+    out += ",\"courseLength\":" + std::to_string(table.courseLength);
+    out += ",\"status\":\"";
+    out += kor::raceStatusName(analysis.status);
+    out += "\",\"time\":" + std::to_string(analysis.totalTime);
+    out += ",\"visited\":" + std::to_string(analysis.visited);
+    out += ",\"mac\":\"";
+    out += kor::macStatusName(mac);
+    out += "\",\"presses\":[";
+    for (size_t i = 0; i < table.presses.size(); i++) {
+      if (i) out += ',';
+      out += "{\"checkpoint\":" + std::to_string(table.presses[i].checkpoint);
+      out += ",\"timestamp\":" + std::to_string(table.presses[i].timestamp);
+      out += ",\"split\":";
+      out += analysis.splits[i] >= 0 ? std::to_string(analysis.splits[i]) : "null";
+      out += analysis.outOfOrder[i] ? ",\"outOfOrder\":true}" : ",\"outOfOrder\":false}";
+    }
+    out += "]}";
+  }
+
+  void decode(const char* source, const std::string& contents) {
+    std::string_view rest(contents);
+    size_t lineNumber = 0;
+    while (!rest.empty()) {
+      size_t end = rest.find('\n');
+      std::string_view line = rest.substr(0, end);
+      rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+      decodeLine(source, ++lineNumber, line);
+    }
+  }
+};
+
+bool parseImpl(const char* name, kor::Base64Impl& impl) {
+  for (kor::Base64Impl candidate : {kor::Base64Impl::Scalar, kor::Base64Impl::Sse, kor::Base64Impl::Avx2}) {
+    if (strcmp(name, kor::base64ImplName(candidate)) == 0) {
+      impl = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Decoder decoder;
+  std::vector<const char*> files;
+  uint8_t macKey[kor::MAC_KEY_SIZE];
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+      const char* format = argv[++i];
+      if (strcmp(format, "csv") == 0) {
+        decoder.format = Format::Csv;
+      } else if (strcmp(format, "json") == 0) {
+        decoder.format = Format::Json;
+      } else {
+        fprintf(stderr, "Unknown format %s\n", format);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--impl") == 0 && i + 1 < argc) {
+      if (!parseImpl(argv[++i], decoder.impl) || !kor::base64ImplSupported(decoder.impl)) {
+        fprintf(stderr, "Decoder %s not available on this CPU\n", argv[i]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--mac-key") == 0 && i + 1 < argc) {
+      if (!kor::parseMacKey(argv[++i], macKey)) {
+        fprintf(stderr, "The MAC key is 32 hex digits\n");
+        return 1;
+      }
+      decoder.macKey = macKey;
+    } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+      fprintf(stderr, "Usage: %s [--format csv|json] [--impl scalar|sse|avx2] [--mac-key HEX] [FILE]...\n", argv[0]);
+      return 1;
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) files.push_back("-");
+
+  decoder.begin();
+  for (const char* file : files) {
+    std::stringstream contents;
+    if (strcmp(file, "-") == 0) {
+      contents << std::cin.rdbuf();
+    } else {
+      std::ifstream in(file);
+      if (!in) {
+        fprintf(stderr, "Cannot open %s\n", file);
+        return 1;
+      }
+      contents << in.rdbuf();
+    }
+    decoder.decode(file, contents.str());
+  }
+  decoder.end();
+
+  fprintf(stderr, "Decoded %zu dumps with the %s decoder, %zu invalid", decoder.dumps,
+          kor::base64ImplName(decoder.impl), decoder.invalid);
+  if (decoder.macKey) fprintf(stderr, ", %zu without a valid MAC", decoder.unverified);
+  fprintf(stderr, "\n");
+  return decoder.invalid || decoder.unverified ? 2 : 0;
+}
@@ -0,0 +1,268 @@
+#include "Adafruit_PN532.h"
+
+#include <SPI.h>
+
+static const uint8_t pn532ack[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+static const uint8_t pn532response_firmwarevers[] = {0x00, 0x00, 0xFF, 0x06, 0xFA, 0xD5};
+
+static uint8_t pn532_packetbuffer[PN532_PACKBUFFSIZ];
+
+bool Adafruit_PN532::begin() {
+  pinMode(ss_, OUTPUT);
+  digitalWrite(ss_, HIGH);
+  SPI.begin();
+
+  // Wake the chip: hold SS low for a moment
+  digitalWrite(ss_, LOW);
+  delay(2);
+  digitalWrite(ss_, HIGH);
+
+  // Dummy command to get synced up, the response is ignored
+  pn532_packetbuffer[0] = PN532_COMMAND_GETFIRMWAREVERSION;
+  sendCommandCheckAck(pn532_packetbuffer, 1);
+  return true;
+}
+
+uint32_t Adafruit_PN532::getFirmwareVersion() {
+  uint32_t response;
+
+  pn532_packetbuffer[0] = PN532_COMMAND_GETFIRMWAREVERSION;
+  if (!sendCommandCheckAck(pn532_packetbuffer, 1)) {
+    return 0;
+  }
+
+  readdata(pn532_packetbuffer, 13);
+  if (memcmp(pn532_packetbuffer, pn532response_firmwarevers, 6) != 0) {
+    return 0;
+  }
+
+  int offset = 7;
+  response = pn532_packetbuffer[offset++];
+  response <<= 8;
+  response |= pn532_packetbuffer[offset++];
+  response <<= 8;
+  response |= pn532_packetbuffer[offset++];
+  response <<= 8;
+  response |= pn532_packetbuffer[offset++];
+  return response;
+}
+
+bool Adafruit_PN532::sendCommandCheckAck(uint8_t* cmd, uint8_t cmdlen, uint16_t timeout) {
+  writecommand(cmd, cmdlen);
+
+  if (!waitready(timeout)) {
+    return false;
+  }
+  if (!readack()) {
+    return false;
+  }
+
+  // On SPI, also wait until the response is ready
+  if (!waitready(timeout)) {
+    return false;
+  }
+  return true;
+}
+
+bool Adafruit_PN532::SAMConfig() {
+  pn532_packetbuffer[0] = PN532_COMMAND_SAMCONFIGURATION;
+  pn532_packetbuffer[1] = 0x01;  // Normal mode
+  pn532_packetbuffer[2] = 0x14;  // Timeout 50ms * 20 = 1 second
+  pn532_packetbuffer[3] = 0x01;  // Use IRQ pin
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, 4)) {
+    return false;
+  }
+
+  readdata(pn532_packetbuffer, 9);
+  return pn532_packetbuffer[6] == 0x15;
+}
+
+bool Adafruit_PN532::setPassiveActivationRetries(uint8_t maxRetries) {
+  pn532_packetbuffer[0] = PN532_COMMAND_RFCONFIGURATION;
+  pn532_packetbuffer[1] = 5;     // Config item 5 (MaxRetries)
+  pn532_packetbuffer[2] = 0xFF;  // MxRtyATR (default = 0xFF)
+  pn532_packetbuffer[3] = 0x01;  // MxRtyPSL (default = 0x01)
+  pn532_packetbuffer[4] = maxRetries;
+
+  return sendCommandCheckAck(pn532_packetbuffer, 5);
+}
+
+bool Adafruit_PN532::readPassiveTargetID(uint8_t cardbaudrate, uint8_t* uid, uint8_t* uidLength, uint16_t timeout) {
+  pn532_packetbuffer[0] = PN532_COMMAND_INLISTPASSIVETARGET;
+  pn532_packetbuffer[1] = 1;  // Max 1 card at once
+  pn532_packetbuffer[2] = cardbaudrate;
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, 3, timeout)) {
+    return false;  // No card read
+  }
+
+  return readDetectedPassiveTargetID(uid, uidLength);
+}
+
+bool Adafruit_PN532::readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLength) {
+  // ISO14443A card response: 00 00 FF LEN LCS D5 4B NbTg Tg SENS_RES(2) SEL_RES NFCIDLength NFCID...
+  readdata(pn532_packetbuffer, 20);
+
+  if (pn532_packetbuffer[7] != 1) {
+    return false;
+  }
+
+  *uidLength = pn532_packetbuffer[12];
+  for (uint8_t i = 0; i < pn532_packetbuffer[12]; i++) {
+    uid[i] = pn532_packetbuffer[13 + i];
+  }
+  return true;
+}
+
+bool Adafruit_PN532::inDataExchange(uint8_t* send, uint8_t sendLength, uint8_t* response, uint8_t* responseLength) {
+  if (sendLength > PN532_PACKBUFFSIZ - 2) {
+    return false;
+  }
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = 1;  // Tg of the listed tag
+  for (uint8_t i = 0; i < sendLength; ++i) {
+    pn532_packetbuffer[i + 2] = send[i];
+  }
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, sendLength + 2, 1000)) {
+    return false;
+  }
+  if (!waitready(1000)) {
+    return false;
+  }
+
+  readdata(pn532_packetbuffer, sizeof(pn532_packetbuffer));
+
+  if (pn532_packetbuffer[0] != 0 || pn532_packetbuffer[1] != 0 || pn532_packetbuffer[2] != 0xFF) {
+    return false;
+  }
+
+  uint8_t length = pn532_packetbuffer[3];
+  if (pn532_packetbuffer[4] != (uint8_t)(~length + 1)) {
+    return false;
+  }
+  if (pn532_packetbuffer[5] != PN532_PN532TOHOST || pn532_packetbuffer[6] != PN532_RESPONSE_INDATAEXCHANGE) {
+    return false;
+  }
+  if ((pn532_packetbuffer[7] & 0x3F) != 0) {
+    return false;
+  }
+
+  length -= 3;
+  if (length > *responseLength) {
+    length = *responseLength;
+  }
+  for (uint8_t i = 0; i < length; ++i) {
+    response[i] = pn532_packetbuffer[8 + i];
+  }
+  *responseLength = length;
+  return true;
+}
+
+uint8_t Adafruit_PN532::ntag2xx_ReadPage(uint8_t page, uint8_t* buffer) {
+  if (page >= 231) {
+    return 0;
+  }
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = 1;     // Card number
+  pn532_packetbuffer[2] = 0x30;  // NTAG READ
+  pn532_packetbuffer[3] = page;
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, 4)) {
+    return 0;
+  }
+
+  // READ returns 16 bytes (4 pages), only the first page is used
+  readdata(pn532_packetbuffer, 26);
+  if (pn532_packetbuffer[7] != 0x00) {
+    return 0;
+  }
+
+  memcpy(buffer, pn532_packetbuffer + 8, 4);
+  return 1;
+}
+
+uint8_t Adafruit_PN532::ntag2xx_WritePage(uint8_t page, uint8_t* data) {
+  if (page < 4 || page > 225) {
+    return 0;
+  }
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
+  pn532_packetbuffer[1] = 1;     // Card number
+  pn532_packetbuffer[2] = 0xA2;  // NTAG WRITE
+  pn532_packetbuffer[3] = page;
+  memcpy(pn532_packetbuffer + 4, data, 4);
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, 8)) {
+    return 0;
+  }
+  delay(10);
+
+  // The library reads the response but never checks its status byte
+  readdata(pn532_packetbuffer, 26);
+  return 1;
+}
+
+bool Adafruit_PN532::readack() {
+  uint8_t ackbuff[6];
+  readdata(ackbuff, 6);
+  return memcmp(ackbuff, pn532ack, 6) == 0;
+}
+
+bool Adafruit_PN532::isready() {
+  digitalWrite(ss_, LOW);
+  SPI.transfer(PN532_SPI_STATREAD);
+  uint8_t reply = SPI.transfer(0x00);
+  digitalWrite(ss_, HIGH);
+  return reply == PN532_SPI_READY;
+}
+
+bool Adafruit_PN532::waitready(uint16_t timeout) {
+  uint16_t timer = 0;
+  while (!isready()) {
+    if (timeout != 0) {
+      timer += 10;
+      if (timer > timeout) {
+        return false;
+      }
+    }
+    delay(10);
+  }
+  return true;
+}
+
+void Adafruit_PN532::readdata(uint8_t* buff, uint8_t n) {
+  digitalWrite(ss_, LOW);
+  SPI.transfer(PN532_SPI_DATAREAD);
+  for (uint8_t i = 0; i < n; i++) {
+    buff[i] = SPI.transfer(0x00);
+  }
+  digitalWrite(ss_, HIGH);
+}
+
+void Adafruit_PN532::writecommand(uint8_t* cmd, uint8_t cmdlen) {
+  uint8_t checksum = PN532_PREAMBLE + PN532_STARTCODE1 + PN532_STARTCODE2;
+  cmdlen++;
+
+  digitalWrite(ss_, LOW);
+  SPI.transfer(PN532_SPI_DATAWRITE);
+  SPI.transfer(PN532_PREAMBLE);
+  SPI.transfer(PN532_STARTCODE1);
+  SPI.transfer(PN532_STARTCODE2);
+  SPI.transfer(cmdlen);
+  SPI.transfer(~cmdlen + 1);
+
+  SPI.transfer(PN532_HOSTTOPN532);
+  checksum += PN532_HOSTTOPN532;
+  for (uint8_t i = 0; i < cmdlen - 1; i++) {
+    SPI.transfer(cmd[i]);
+    checksum += cmd[i];
+  }
+
+  SPI.transfer(~checksum);
+  SPI.transfer(PN532_POSTAMBLE);
+  digitalWrite(ss_, HIGH);
+}
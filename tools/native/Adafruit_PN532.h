@@ -0,0 +1,67 @@
+#ifndef ADAFRUIT_PN532_H
+#define ADAFRUIT_PN532_H
+
+// Host build of the subset of the Adafruit PN532 library the firmware uses.
+// The SPI code paths follow the library (frame building, status polling with
+// delay(10), ACK check, fixed-size response reads, the missing status check
+// in ntag2xx_WritePage), so the firmware sees the same timing and failure
+// modes as on the ESP8266. Bytes go over the host SPI bus to the emulated
+// PN532 attached to the slave select pin (see sim.h).
+
+#include <Arduino.h>
+
+#define PN532_PREAMBLE (0x00)
+#define PN532_STARTCODE1 (0x00)
+#define PN532_STARTCODE2 (0xFF)
+#define PN532_POSTAMBLE (0x00)
+
+#define PN532_HOSTTOPN532 (0xD4)
+#define PN532_PN532TOHOST (0xD5)
+
+#define PN532_COMMAND_GETFIRMWAREVERSION (0x02)
+#define PN532_COMMAND_SAMCONFIGURATION (0x14)
+#define PN532_COMMAND_RFCONFIGURATION (0x32)
+#define PN532_COMMAND_INDATAEXCHANGE (0x40)
+#define PN532_COMMAND_INLISTPASSIVETARGET (0x4A)
+
+#define PN532_RESPONSE_INDATAEXCHANGE (0x41)
+#define PN532_RESPONSE_INLISTPASSIVETARGET (0x4B)
+
+#define PN532_SPI_STATREAD (0x02)
+#define PN532_SPI_DATAWRITE (0x01)
+#define PN532_SPI_DATAREAD (0x03)
+#define PN532_SPI_READY (0x01)
+
+#define PN532_MIFARE_ISO14443A (0x00)
+
+#define PN532_PACKBUFFSIZ 64
+
+class Adafruit_PN532 {
+ public:
+  explicit Adafruit_PN532(uint8_t ss) : ss_(ss) {}
+
+  bool begin();
+  uint32_t getFirmwareVersion();
+  bool SAMConfig();
+  bool setPassiveActivationRetries(uint8_t maxRetries);
+
+  bool sendCommandCheckAck(uint8_t* cmd, uint8_t cmdlen, uint16_t timeout = 100);
+
+  bool readPassiveTargetID(uint8_t cardbaudrate, uint8_t* uid, uint8_t* uidLength, uint16_t timeout = 0);
+  bool readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLength);
+  bool inDataExchange(uint8_t* send, uint8_t sendLength, uint8_t* response, uint8_t* responseLength);
+
+  uint8_t ntag2xx_ReadPage(uint8_t page, uint8_t* buffer);
+  uint8_t ntag2xx_WritePage(uint8_t page, uint8_t* data);
+
+ private:
+  bool readack();
+  bool isready();
+  bool waitready(uint16_t timeout);
+  void writecommand(uint8_t* cmd, uint8_t cmdlen);
+  void readdata(uint8_t* buff, uint8_t n);
+
+  uint8_t ss_;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Host build of the parts of the Arduino core the firmware uses, so src/ can
+// run natively against simulated PN532 readers. Time is virtual: delay()
+// advances the clock instantly.
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+
+#define DEC 10
+#define HEX 16
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+#define PROGMEM
+
+class String {
+ public:
+  String() {}
+  String(const char* text) : value_(text ? text : "") {}
+  String(const __FlashStringHelper* text) : value_(reinterpret_cast<const char*>(text)) {}
+  String(const std::string& text) : value_(text) {}
+  explicit String(char c) : value_(1, c) {}
+  explicit String(int number) : value_(std::to_string(number)) {}
+  explicit String(unsigned int number) : value_(std::to_string(number)) {}
+  explicit String(long number) : value_(std::to_string(number)) {}
+  explicit String(unsigned long number) : value_(std::to_string(number)) {}
+
+  unsigned int length() const { return value_.size(); }
+  const char* c_str() const { return value_.c_str(); }
+  bool reserve(unsigned int size) { value_.reserve(size); return true; }
+
+  char operator[](unsigned int index) const { return index < value_.size() ? value_[index] : 0; }
+  char& operator[](unsigned int index) { return value_[index]; }
+  char charAt(unsigned int index) const { return (*this)[index]; }
+
+  String& operator+=(const String& other) { value_ += other.value_; return *this; }
+  String& operator+=(const char* other) { value_ += other; return *this; }
+  String& operator+=(char c) { value_ += c; return *this; }
+  bool concat(const String& other) { value_ += other.value_; return true; }
+  bool concat(char c) { value_ += c; return true; }
+
+  bool operator==(const String& other) const { return value_ == other.value_; }
+  bool operator!=(const String& other) const { return value_ != other.value_; }
+  bool equals(const String& other) const { return value_ == other.value_; }
+
+  bool startsWith(const String& prefix) const { return value_.compare(0, prefix.value_.size(), prefix.value_) == 0; }
+  bool endsWith(const String& suffix) const {
+    return value_.size() >= suffix.value_.size() &&
+           value_.compare(value_.size() - suffix.value_.size(), suffix.value_.size(), suffix.value_) == 0;
+  }
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t pos = value_.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  int indexOf(const String& text, unsigned int from = 0) const {
+    size_t pos = value_.find(text.value_, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  String substring(unsigned int from) const { return from < value_.size() ? String(value_.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    return from < value_.size() && from < to ? String(value_.substr(from, to - from)) : String();
+  }
+  void trim() {
+    size_t start = value_.find_first_not_of(" \t\r\n");
+    size_t end = value_.find_last_not_of(" \t\r\n");
+    value_ = start == std::string::npos ? std::string() : value_.substr(start, end - start + 1);
+  }
+  long toInt() const { return strtol(value_.c_str(), nullptr, 10); }
+
+  friend String operator+(const String& a, const String& b) { return String(a.value_ + b.value_); }
+  friend String operator+(const String& a, const char* b) { return String(a.value_ + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.value_); }
+  friend String operator+(const String& a, char b) { return String(a.value_ + b); }
+
+ private:
+  std::string value_;
+};
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+#include "HardwareSerial.h"
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Host EEPROM emulation: a RAM array that survives simulated reboots
+class EEPROMClass {
+ public:
+  EEPROMClass() { memset(data_, 0xFF, sizeof(data_)); }  // Erased flash
+
+  void begin(size_t size) { size_ = size < sizeof(data_) ? size : sizeof(data_); }
+  void end() {}
+  bool commit() { commits_++; return true; }
+
+  uint8_t read(int address) const { return data_[address]; }
+  void write(int address, uint8_t value) { data_[address] = value; }
+
+  template <typename T>
+  T& get(int address, T& value) const {
+    memcpy(&value, data_ + address, sizeof(T));
+    return value;
+  }
+
+  template <typename T>
+  const T& put(int address, const T& value) {
+    memcpy(data_ + address, &value, sizeof(T));
+    return value;
+  }
+
+  size_t length() const { return size_; }
+  uint32_t commits() const { return commits_; }
+
+ private:
+  uint8_t data_[4096];
+  size_t size_ = 0;
+  uint32_t commits_ = 0;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
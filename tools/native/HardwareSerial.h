@@ -0,0 +1,52 @@
+#ifndef HARDWARESERIAL_H
+#define HARDWARESERIAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class __FlashStringHelper;
+class String;
+
+// Serial port backed by stdout/stdin. Output can be muted for benchmarks.
+class HardwareSerial {
+ public:
+  void begin(unsigned long baud);
+  int available();
+  int read();
+  void flush() {}
+
+  size_t write(uint8_t byte);
+  size_t write(const uint8_t* buffer, size_t size);
+
+  size_t print(const __FlashStringHelper* text);
+  size_t print(const String& text);
+  size_t print(const char* text);
+  size_t print(char c);
+  size_t print(unsigned char number, int base = 10);
+  size_t print(int number, int base = 10);
+  size_t print(unsigned int number, int base = 10);
+  size_t print(long number, int base = 10);
+  size_t print(unsigned long number, int base = 10);
+  size_t print(double number, int digits = 2);
+
+  size_t println();
+  template <typename T>
+  size_t println(const T& value) { size_t n = print(value); return n + println(); }
+  template <typename T>
+  size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+
+  // Host only: silence output, feed input, copy output into a string
+  void setMuted(bool muted) { muted_ = muted; }
+  void inject(const char* text);
+  void setCapture(std::string* capture) { capture_ = capture; }
+
+ private:
+  size_t printNumber(unsigned long number, int base);
+  bool muted_ = false;
+  std::string* capture_ = nullptr;
+};
+
+extern HardwareSerial Serial;
+
+#endif
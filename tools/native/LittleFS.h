@@ -0,0 +1,83 @@
+#ifndef LITTLEFS_H
+#define LITTLEFS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+// Host flash file system: files are byte vectors that survive simulated
+// reboots. Covers the part of the ESP8266 FS API the firmware uses, with
+// the modes "r", "w" (truncate) and "a" (append).
+
+class File {
+ public:
+  File() {}
+  File(std::vector<uint8_t>* data, bool writable, bool append)
+      : data_(data), writable_(writable), position_(append ? data->size() : 0) {}
+
+  explicit operator bool() const { return data_ != nullptr; }
+
+  size_t write(const uint8_t* buffer, size_t size) {
+    if (!data_ || !writable_) return 0;
+    if (position_ + size > data_->size()) data_->resize(position_ + size);
+    memcpy(data_->data() + position_, buffer, size);
+    position_ += size;
+    return size;
+  }
+
+  size_t read(uint8_t* buffer, size_t size) {
+    if (!data_) return 0;
+    size_t n = position_ < data_->size() ? data_->size() - position_ : 0;
+    if (n > size) n = size;
+    memcpy(buffer, data_->data() + position_, n);
+    position_ += n;
+    return n;
+  }
+
+  int available() const { return data_ && position_ < data_->size() ? (int)(data_->size() - position_) : 0; }
+  size_t size() const { return data_ ? data_->size() : 0; }
+  size_t position() const { return position_; }
+
+  bool seek(uint32_t position) {
+    if (!data_ || position > data_->size()) return false;
+    position_ = position;
+    return true;
+  }
+
+  void flush() {}
+  void close() { data_ = nullptr; }
+
+ private:
+  std::vector<uint8_t>* data_ = nullptr;
+  bool writable_ = false;
+  size_t position_ = 0;
+};
+
+class FS {
+ public:
+  bool begin() { return true; }
+  void end() {}
+
+  File open(const char* path, const char* mode) {
+    if (mode[0] == 'r') {
+      auto it = files_.find(path);
+      return it == files_.end() ? File() : File(&it->second, false, false);
+    }
+    std::vector<uint8_t>& data = files_[path];
+    if (mode[0] == 'w') data.clear();
+    return File(&data, true, mode[0] == 'a');
+  }
+
+  bool exists(const char* path) const { return files_.count(path) > 0; }
+  bool remove(const char* path) { return files_.erase(path) > 0; }
+
+ private:
+  std::map<std::string, std::vector<uint8_t>> files_;
+};
+
+extern FS LittleFS;
+
+#endif
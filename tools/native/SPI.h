@@ -0,0 +1,16 @@
+#ifndef SPI_H
+#define SPI_H
+
+#include <cstdint>
+
+// Host SPI bus: bytes go to the emulated PN532 whose slave select pin is low
+class SPIClass {
+ public:
+  void begin() {}
+  void end() {}
+  uint8_t transfer(uint8_t data);
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+class TwoWire {
+ public:
+  void begin() {}
+};
+
+extern TwoWire Wire;
+
+#endif
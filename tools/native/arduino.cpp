@@ -0,0 +1,129 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <LittleFS.h>
+#include <SPI.h>
+#include <Wire.h>
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+#include "pn532_emulator.h"
+#include "sim.h"
+
+HardwareSerial Serial;
+SPIClass SPI;
+TwoWire Wire;
+EEPROMClass EEPROM;
+FS LittleFS;
+
+static uint64_t clockUs = 0;
+static void (*toneHook)(unsigned int, unsigned long) = nullptr;
+static std::string serialInput;
+static std::map<uint8_t, Pn532Emulator*> spiDevices;
+static Pn532Emulator* selectedDevice = nullptr;
+
+uint64_t simMicros() { return clockUs; }
+void simAdvance(uint64_t us) { clockUs += us; }
+void simSetToneHook(void (*hook)(unsigned int, unsigned long)) { toneHook = hook; }
+
+void simAttachPn532(uint8_t ssPin, Pn532Emulator* pn532) { spiDevices[ssPin] = pn532; }
+
+Pn532Emulator* simPn532(uint8_t ssPin) {
+  auto it = spiDevices.find(ssPin);
+  return it == spiDevices.end() ? nullptr : it->second;
+}
+
+uint32_t millis() { return (uint32_t)(clockUs / 1000); }
+uint32_t micros() { return (uint32_t)clockUs; }
+void delay(uint32_t ms) { clockUs += (uint64_t)ms * 1000; }
+void delayMicroseconds(uint32_t us) { clockUs += us; }
+void yield() {}
+
+void pinMode(uint8_t, uint8_t) {}
+// Slave select lines of attached PN532s frame their SPI transactions
+void digitalWrite(uint8_t pin, uint8_t value) {
+  Pn532Emulator* device = simPn532(pin);
+  if (!device) return;
+
+  if (value == LOW && selectedDevice != device) {
+    if (selectedDevice) selectedDevice->deselect();
+    selectedDevice = device;
+    device->select();
+  } else if (value == HIGH && selectedDevice == device) {
+    selectedDevice = nullptr;
+    device->deselect();
+  }
+}
+int digitalRead(uint8_t) { return LOW; }
+void noTone(uint8_t) {}
+
+void tone(uint8_t, unsigned int frequency, unsigned long duration) {
+  if (toneHook) toneHook(frequency, duration);
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  if (!selectedDevice) {
+    simAdvance(8);  // Nobody drives MISO
+    return 0xFF;
+  }
+  return selectedDevice->transfer(data);
+}
+
+void HardwareSerial::begin(unsigned long) {}
+
+int HardwareSerial::available() {
+  return (int)serialInput.size();
+}
+
+int HardwareSerial::read() {
+  if (serialInput.empty()) return -1;
+  int c = (unsigned char)serialInput[0];
+  serialInput.erase(0, 1);
+  return c;
+}
+
+void HardwareSerial::inject(const char* text) {
+  serialInput += text;
+}
+
+size_t HardwareSerial::write(uint8_t byte) {
+  if (!muted_) fputc(byte, stdout);
+  if (capture_) capture_->push_back((char)byte);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  if (!muted_) fwrite(buffer, 1, size, stdout);
+  if (capture_) capture_->append((const char*)buffer, size);
+  return size;
+}
+
+size_t HardwareSerial::print(const __FlashStringHelper* text) { return print(reinterpret_cast<const char*>(text)); }
+size_t HardwareSerial::print(const String& text) { return print(text.c_str()); }
+size_t HardwareSerial::print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+size_t HardwareSerial::print(char c) { return write((uint8_t)c); }
+size_t HardwareSerial::print(unsigned char number, int base) { return printNumber(number, base); }
+size_t HardwareSerial::print(unsigned int number, int base) { return printNumber(number, base); }
+size_t HardwareSerial::print(unsigned long number, int base) { return printNumber(number, base); }
+
+size_t HardwareSerial::print(int number, int base) { return print((long)number, base); }
+
+size_t HardwareSerial::print(long number, int base) {
+  if (number < 0 && base == 10) return print('-') + printNumber((unsigned long)-number, 10);
+  return printNumber((unsigned long)number, base);
+}
+
+size_t HardwareSerial::print(double number, int digits) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.*f", digits, number);
+  return print(text);
+}
+
+size_t HardwareSerial::println() { return print("\r\n"); }
+
+size_t HardwareSerial::printNumber(unsigned long number, int base) {
+  char text[32];
+  snprintf(text, sizeof(text), base == 16 ? "%lX" : "%lu", number);
+  return print(text);
+}
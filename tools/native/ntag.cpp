@@ -0,0 +1,192 @@
+#include "ntag.h"
+
+#include <cstring>
+
+NtagTag::NtagTag(NtagModel model, uint32_t serial) : model_(model) {
+  switch (model) {
+    case NTAG215: pageCount_ = 135; break;
+    case NTAG216: pageCount_ = 231; break;
+    default: pageCount_ = 45; break;
+  }
+
+  uid_[0] = 0x04;  // NXP
+  uid_[1] = serial & 0xFF;
+  uid_[2] = (serial >> 8) & 0xFF;
+  uid_[3] = (serial >> 16) & 0xFF;
+  uid_[4] = (serial >> 24) & 0xFF;
+  uid_[5] = 0x4B;
+  uid_[6] = 0x80;
+  format();
+}
+
+uint16_t NtagTag::userBytes() const {
+  return (dynamicLockPage() - 4) * 4;
+}
+
+void NtagTag::format() {
+  memset(memory_, 0, sizeof(memory_));
+
+  // Pages 0-2: UID with block check characters, internal byte, static lock bytes
+  uint8_t* p = memory_;
+  p[0] = uid_[0];
+  p[1] = uid_[1];
+  p[2] = uid_[2];
+  p[3] = 0x88 ^ uid_[0] ^ uid_[1] ^ uid_[2];
+  memcpy(p + 4, uid_ + 3, 4);
+  p[8] = uid_[3] ^ uid_[4] ^ uid_[5] ^ uid_[6];
+  p[9] = 0x48;
+
+  // Page 3: capability container, NDEF 1.0, data area size / 8, read/write
+  uint8_t* cc = page(3);
+  cc[0] = 0xE1;
+  cc[1] = 0x10;
+  cc[2] = userBytes() / 8;
+  cc[3] = 0x00;
+
+  // Empty NDEF message
+  page(4)[0] = 0x03;
+  page(4)[1] = 0x00;
+  page(4)[2] = 0xFE;
+
+  // Dynamic lock bytes and configuration pages
+  page(dynamicLockPage())[3] = 0xBD;
+  uint8_t* cfg0 = page(dynamicLockPage() + 1);
+  cfg0[0] = 0x04;
+  cfg0[3] = 0xFF;  // AUTH0: no password protection
+  page(dynamicLockPage() + 2)[1] = 0x05;
+}
+
+void NtagTag::writeNdef(const uint8_t* message, size_t length) {
+  uint8_t* data = page(4);
+  size_t n = 0;
+  data[n++] = 0x03;
+  data[n++] = (uint8_t)length;
+  memcpy(data + n, message, length);
+  n += length;
+  data[n++] = 0xFE;
+}
+
+void NtagTag::formatNdef(const uint8_t* message, size_t length) {
+  format();
+  writeNdef(message, length);
+}
+
+void NtagTag::formatText(const char* text) {
+  format();
+  uint8_t record[256];
+  size_t textLength = strlen(text);
+  size_t n = 0;
+  record[n++] = 0xD1;  // MB, ME, SR, TNF=1
+  record[n++] = 0x01;
+  record[n++] = (uint8_t)(3 + textLength);
+  record[n++] = 'T';
+  record[n++] = 0x02;  // UTF-8, language code length 2
+  record[n++] = 'e';
+  record[n++] = 'n';
+  memcpy(record + n, text, textLength);
+  writeNdef(record, n + textLength);
+}
+
+void NtagTag::formatUri(uint8_t uriCode, const char* uri) {
+  format();
+  uint8_t record[256];
+  size_t uriLength = strlen(uri);
+  size_t n = 0;
+  record[n++] = 0xD1;
+  record[n++] = 0x01;
+  record[n++] = (uint8_t)(1 + uriLength);
+  record[n++] = 'U';
+  record[n++] = uriCode;
+  memcpy(record + n, uri, uriLength);
+  writeNdef(record, n + uriLength);
+}
+
+bool NtagTag::isPageLocked(uint16_t p) const {
+  if (p < 3) return true;
+  if (p >= pageCount_) return true;
+
+  const uint8_t* staticLock = page(2) + 2;
+  if (p == 3) return staticLock[0] & 0x08;
+  if (p < 16) {
+    uint8_t bit = p;  // L4..L7 in byte 0 bits 4..7, L8..L15 in byte 1
+    return bit < 8 ? staticLock[0] & (1 << bit) : staticLock[1] & (1 << (bit - 8));
+  }
+  if (p >= dynamicLockPage()) return false;
+
+  // Dynamic lock bits: NTAG213 locks 2 pages per bit, NTAG215/216 16 pages
+  uint16_t pagesPerBit = model_ == NTAG213 ? 2 : 16;
+  uint16_t bit = (p - 16) / pagesPerBit;
+  const uint8_t* dynamicLock = page(dynamicLockPage());
+  return bit < 16 && (dynamicLock[bit / 8] & (1 << (bit % 8)));
+}
+
+void NtagTag::writePage(uint16_t p, const uint8_t* data) {
+  uint8_t* target = page(p);
+  if (p == 2) {
+    // Only the static lock bytes are writable, and they are one-time programmable
+    target[2] |= data[2];
+    target[3] |= data[3];
+  } else if (p == 3 || p == dynamicLockPage()) {
+    // Capability container and dynamic lock bytes are OTP as well
+    for (uint8_t i = 0; i < (p == 3 ? 4 : 3); i++) target[i] |= data[i];
+  } else {
+    memcpy(target, data, 4);
+  }
+}
+
+bool NtagTag::isWrite(const uint8_t* command, size_t length) const {
+  return length >= 1 && command[0] == NTAG_CMD_WRITE;
+}
+
+void NtagTag::tearWrite(const uint8_t* command) {
+  uint16_t p = command[1];
+  if (p < 4 || p >= dynamicLockPage() || isPageLocked(p)) return;
+  memcpy(page(p), command + 2, 2);
+}
+
+size_t NtagTag::execute(const uint8_t* command, size_t length, uint8_t* response, uint8_t* nak) {
+  *nak = NTAG_NAK_INVALID_ARGUMENT;
+  if (length == 0) return 0;
+
+  switch (command[0]) {
+    case NTAG_CMD_GET_VERSION: {
+      const uint8_t storageSize = model_ == NTAG213 ? 0x0F : model_ == NTAG215 ? 0x11 : 0x13;
+      const uint8_t version[8] = {0x00, 0x04, 0x04, 0x02, 0x01, 0x00, storageSize, 0x03};
+      memcpy(response, version, 8);
+      return 8;
+    }
+
+    case NTAG_CMD_READ: {
+      if (length < 2 || command[1] >= pageCount_) return 0;
+      // Four pages, rolling over to page 0 past the end of memory
+      for (uint8_t i = 0; i < 4; i++) {
+        uint16_t p = (command[1] + i) % pageCount_;
+        bool hidden = p >= dynamicLockPage() + 3;  // PWD and PACK read as zero
+        for (uint8_t j = 0; j < 4; j++) response[i * 4 + j] = hidden ? 0 : page(p)[j];
+      }
+      return 16;
+    }
+
+    case NTAG_CMD_FAST_READ: {
+      if (length < 3 || command[1] > command[2] || command[2] >= pageCount_) return 0;
+      size_t n = 0;
+      for (uint16_t p = command[1]; p <= command[2]; p++) {
+        bool hidden = p >= dynamicLockPage() + 3;
+        for (uint8_t j = 0; j < 4; j++) response[n++] = hidden ? 0 : page(p)[j];
+      }
+      return n;
+    }
+
+    case NTAG_CMD_WRITE: {
+      if (length < 6 || command[1] < 2 || command[1] >= pageCount_) return 0;
+      uint16_t p = command[1];
+      if (p != 2 && p != dynamicLockPage() && isPageLocked(p)) return 0;
+      writePage(p, command + 2);
+      response[0] = NTAG_ACK;
+      return 1;
+    }
+
+    default:
+      return 0;
+  }
+}
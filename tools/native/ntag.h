@@ -0,0 +1,71 @@
+#ifndef NTAG_H
+#define NTAG_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Memory and command model of NXP NTAG213/215/216 (NFC Forum Type 2)
+
+enum NtagModel {
+  NTAG213,
+  NTAG215,
+  NTAG216
+};
+
+// Tag commands as sent inside InDataExchange
+#define NTAG_CMD_GET_VERSION 0x60
+#define NTAG_CMD_READ 0x30
+#define NTAG_CMD_FAST_READ 0x3A
+#define NTAG_CMD_WRITE 0xA2
+
+// 4-bit NAK values
+#define NTAG_NAK_INVALID_ARGUMENT 0x00
+#define NTAG_NAK_EEPROM_WRITE_ERROR 0x05
+
+#define NTAG_ACK 0x0A
+
+class NtagTag {
+ public:
+  NtagTag(NtagModel model = NTAG213, uint32_t serial = 1);
+
+  NtagModel model() const { return model_; }
+  uint16_t pageCount() const { return pageCount_; }
+  uint16_t dynamicLockPage() const { return pageCount_ - 5; }
+  uint16_t userBytes() const;
+
+  const uint8_t* uid() const { return uid_; }
+  uint8_t uidLength() const { return 7; }
+  const uint8_t* page(uint16_t page) const { return memory_ + page * 4; }
+  uint8_t* page(uint16_t page) { return memory_ + page * 4; }
+
+  // Wipe to factory state: UID, capability container and an empty NDEF message
+  void format();
+  // Factory state with a single NDEF Text ("en") or URI record
+  void formatText(const char* text);
+  void formatUri(uint8_t uriCode, const char* uri);
+  // Factory state with an arbitrary NDEF message
+  void formatNdef(const uint8_t* message, size_t length);
+
+  // Execute one tag command. Returns the number of response bytes, or 0 with
+  // *nak set when the tag answers with a 4-bit NAK.
+  size_t execute(const uint8_t* command, size_t length, uint8_t* response, uint8_t* nak);
+
+  bool isWrite(const uint8_t* command, size_t length) const;
+
+  // The field dropped while `command` (a WRITE) was programming: the page
+  // is left half old, half new
+  void tearWrite(const uint8_t* command);
+
+  bool isPageLocked(uint16_t page) const;
+
+ private:
+  void writePage(uint16_t page, const uint8_t* data);
+  void writeNdef(const uint8_t* message, size_t length);
+
+  NtagModel model_;
+  uint16_t pageCount_;
+  uint8_t uid_[7];
+  uint8_t memory_[231 * 4];
+};
+
+#endif
@@ -0,0 +1,288 @@
+#include "pn532_emulator.h"
+
+#include <Arduino.h>
+
+#define PN532_HOSTTOPN532 0xD4
+#define PN532_PN532TOHOST 0xD5
+
+// Response status bytes
+#define PN532_STATUS_OK 0x00
+#define PN532_STATUS_TIMEOUT 0x01
+#define PN532_STATUS_BUFFER_TOO_SMALL 0x07
+#define PN532_STATUS_NAK 0x14            // The tag's 4-bit NAK is reported as an error status
+#define PN532_STATUS_WRONG_CONTEXT 0x27
+
+// Largest data field of a normal information frame
+const size_t MAX_FRAME_DATA = 254;
+
+void Pn532Emulator::select() {
+  update(simMicros());
+  operation_ = SPI_PENDING_OPERATION;
+  input_.clear();
+  readOffset_ = 0;
+}
+
+void Pn532Emulator::deselect() {
+  if (operation_ == SPI_DATA_WRITE) {
+    handleFrame();
+  } else if (operation_ == SPI_DATA_READ && readOffset_ > 0 && !output_.empty()) {
+    output_.pop_front();  // A frame is consumed by one read, however many bytes were clocked
+  }
+  operation_ = SPI_IDLE;
+}
+
+uint8_t Pn532Emulator::transfer(uint8_t mosi) {
+  simAdvance(timing_.spiByteUs);
+  uint64_t now = simMicros();
+
+  switch (operation_) {
+    case SPI_PENDING_OPERATION:
+      if (mosi == SPI_OP_DATA_WRITE) {
+        operation_ = SPI_DATA_WRITE;
+      } else if (mosi == SPI_OP_STATUS_READ) {
+        operation_ = SPI_STATUS_READ;
+      } else if (mosi == SPI_OP_DATA_READ) {
+        operation_ = SPI_DATA_READ;
+      }
+      return 0x00;
+
+    case SPI_DATA_WRITE:
+      input_.push_back(mosi);
+      return 0x00;
+
+    case SPI_STATUS_READ:
+      update(now);
+      return !output_.empty() && output_.front().readyUs <= now ? 0x01 : 0x00;
+
+    case SPI_DATA_READ: {
+      update(now);
+      if (output_.empty() || output_.front().readyUs > now) return 0x00;
+      const std::vector<uint8_t>& frame = output_.front().bytes;
+      uint8_t byte = readOffset_ < frame.size() ? frame[readOffset_] : 0x00;
+      readOffset_++;
+      return byte;
+    }
+
+    default:
+      return 0xFF;
+  }
+}
+
+// Advance an InListPassiveTarget in progress up to `nowUs`
+void Pn532Emulator::update(uint64_t nowUs) {
+  while (polling_) {
+    uint64_t attemptUs = pollStartUs_ + (uint64_t)pollAttempts_ * timing_.pollAttemptUs;
+    if (attemptUs > nowUs) return;
+
+    NtagTag* tag = antenna_ ? antenna_->tagInField(attemptUs) : nullptr;
+    uint64_t activatedUs = attemptUs + timing_.activationUs;
+    if (tag && antenna_->presentThroughout(tag, attemptUs, activatedUs)) {
+      target_ = tag;
+      targetContactUs_ = attemptUs;
+      polling_ = false;
+
+      // NbTg, Tg, SENS_RES, SEL_RES, NFCID length, NFCID
+      uint8_t response[20] = {0x4B, 0x01, 0x01, 0x00, 0x44, 0x00, tag->uidLength()};
+      memcpy(response + 7, tag->uid(), tag->uidLength());
+      respond(response, 7 + tag->uidLength(), activatedUs);
+      return;
+    }
+
+    pollAttempts_++;
+    // MxRtyPassiveActivation: 0xFF retries forever, otherwise 1 + n attempts
+    if (maxRetries_ != 0xFF && pollAttempts_ > maxRetries_) {
+      polling_ = false;
+      const uint8_t response[] = {0x4B, 0x00};
+      respond(response, sizeof(response), attemptUs + timing_.pollAttemptUs);
+    }
+  }
+}
+
+void Pn532Emulator::handleFrame() {
+  // Skip the optional preamble, then expect the 00 FF start code
+  size_t i = 0;
+  while (i < input_.size() && input_[i] == 0x00 && !(i + 1 < input_.size() && input_[i + 1] == 0xFF)) i++;
+  if (i + 3 >= input_.size() || input_[i] != 0x00 || input_[i + 1] != 0xFF) {
+    stats_.frameErrors++;
+    return;
+  }
+
+  uint8_t length = input_[i + 2];
+  uint8_t lengthChecksum = input_[i + 3];
+
+  // ACK from the host aborts the command in progress
+  if (length == 0x00 && lengthChecksum == 0xFF) {
+    polling_ = false;
+    output_.clear();
+    return;
+  }
+
+  // LCS must make LEN + LCS zero; extended frames (FF FF) are not supported
+  if ((uint8_t)(length + lengthChecksum) != 0 || length == 0 || i + 4 + length >= input_.size()) {
+    stats_.frameErrors++;
+    return;
+  }
+
+  const uint8_t* body = &input_[i + 4];
+  uint8_t sum = 0;
+  for (uint8_t j = 0; j < length; j++) sum += body[j];
+  if (body[0] != PN532_HOSTTOPN532 || (uint8_t)(sum + body[length]) != 0) {
+    stats_.frameErrors++;
+    return;
+  }
+
+  stats_.frames++;
+
+  // A new command cancels whatever was still running or unread
+  if (polling_ || !output_.empty()) stats_.aborts++;
+  polling_ = false;
+  output_.clear();
+
+  uint64_t now = simMicros();
+  const uint8_t ack[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+  output_.push_back({std::vector<uint8_t>(ack, ack + sizeof(ack)), now + timing_.ackUs});
+
+  execute(body + 1, length - 1, now + timing_.ackUs);
+}
+
+void Pn532Emulator::execute(const uint8_t* data, size_t length, uint64_t startUs) {
+  uint64_t doneUs = startUs + timing_.commandUs;
+
+  switch (data[0]) {
+    case 0x02: {  // GetFirmwareVersion: PN532, v1.6, ISO14443A/B + ISO18092
+      const uint8_t response[] = {0x03, 0x32, 0x01, 0x06, 0x07};
+      respond(response, sizeof(response), doneUs);
+      break;
+    }
+
+    case 0x14: {  // SAMConfiguration
+      const uint8_t response[] = {0x15};
+      respond(response, sizeof(response), doneUs);
+      break;
+    }
+
+    case 0x32: {  // RFConfiguration
+      if (length >= 5 && data[1] == 0x05) maxRetries_ = data[4];  // MaxRetries item
+      const uint8_t response[] = {0x33};
+      respond(response, sizeof(response), doneUs);
+      break;
+    }
+
+    case 0x4A:  // InListPassiveTarget, one ISO14443A target
+      if (length < 3 || data[1] != 0x01 || data[2] != 0x00) {
+        respondError(doneUs);
+        break;
+      }
+      target_ = nullptr;
+      polling_ = true;
+      pollStartUs_ = doneUs;
+      pollAttempts_ = 0;
+      update(simMicros());
+      break;
+
+    case 0x40:  // InDataExchange
+      inDataExchange(data, length, doneUs);
+      break;
+
+    case 0x44:    // InDeselect
+    case 0x52: {  // InRelease
+      target_ = nullptr;
+      const uint8_t response[] = {(uint8_t)(data[0] + 1), PN532_STATUS_OK};
+      respond(response, sizeof(response), doneUs);
+      break;
+    }
+
+    default:
+      respondError(doneUs);
+      break;
+  }
+}
+
+void Pn532Emulator::inDataExchange(const uint8_t* data, size_t length, uint64_t startUs) {
+  if (length < 3 || data[1] != 0x01 || !target_) {
+    const uint8_t response[] = {0x41, PN532_STATUS_WRONG_CONTEXT};
+    respond(response, sizeof(response), startUs);
+    return;
+  }
+
+  const uint8_t* command = data + 2;
+  size_t commandLength = length - 2;
+  uint64_t commandAirUs = (commandLength + 2) * timing_.rfByteUs;  // Command and CRC
+  const uint8_t timeout[] = {0x41, PN532_STATUS_TIMEOUT};
+  stats_.rfExchanges++;
+
+  // The tag must have stayed powered since it was selected, or it lost its state
+  if (!antenna_ || !antenna_->presentThroughout(target_, targetContactUs_, startUs + commandAirUs)) {
+    stats_.rfFailures++;
+    target_ = nullptr;
+    respond(timeout, sizeof(timeout), startUs + timing_.rfTimeoutUs);
+    return;
+  }
+
+  uint8_t response[2 + 1024];
+  response[0] = 0x41;
+  response[1] = PN532_STATUS_OK;
+  uint8_t nak;
+  size_t responseLength;
+  uint64_t doneUs;
+
+  if (target_->isWrite(command, commandLength)) {
+    uint64_t programmedUs = startUs + commandAirUs + timing_.eepromWriteUs;
+    if (!antenna_->presentThroughout(target_, targetContactUs_, programmedUs)) {
+      target_->tearWrite(command);
+      stats_.tornWrites++;
+      stats_.rfFailures++;
+      target_ = nullptr;
+      respond(timeout, sizeof(timeout), startUs + timing_.rfTimeoutUs);
+      return;
+    }
+    responseLength = target_->execute(command, commandLength, response + 2, &nak);
+    doneUs = programmedUs + timing_.rfTurnaroundUs + timing_.rfByteUs;
+  } else {
+    responseLength = target_->execute(command, commandLength, response + 2, &nak);
+    doneUs = startUs + commandAirUs + timing_.rfTurnaroundUs + (responseLength + 2) * timing_.rfByteUs;
+    if (!antenna_->presentThroughout(target_, targetContactUs_, doneUs)) {
+      stats_.rfFailures++;
+      target_ = nullptr;
+      respond(timeout, sizeof(timeout), startUs + timing_.rfTimeoutUs);
+      return;
+    }
+  }
+
+  bool acknowledged = responseLength > 0;
+  if (target_->isWrite(command, commandLength)) responseLength = 0;  // The 4-bit ACK is not passed on
+
+  if (!acknowledged) {
+    const uint8_t failed[] = {0x41, PN532_STATUS_NAK};
+    respond(failed, sizeof(failed), doneUs);
+  } else if (responseLength + 2 > MAX_FRAME_DATA) {
+    const uint8_t failed[] = {0x41, PN532_STATUS_BUFFER_TOO_SMALL};
+    respond(failed, sizeof(failed), doneUs);
+  } else {
+    respond(response, responseLength + 2, doneUs);
+  }
+}
+
+void Pn532Emulator::respond(const uint8_t* data, size_t length, uint64_t readyUs) {
+  std::vector<uint8_t> frame = {0x00, 0x00, 0xFF};
+  uint8_t frameLength = (uint8_t)(length + 1);
+  frame.push_back(frameLength);
+  frame.push_back((uint8_t)(~frameLength + 1));
+  frame.push_back(PN532_PN532TOHOST);
+
+  uint8_t sum = PN532_PN532TOHOST;
+  for (size_t i = 0; i < length; i++) {
+    frame.push_back(data[i]);
+    sum += data[i];
+  }
+  frame.push_back((uint8_t)(~sum + 1));
+  frame.push_back(0x00);
+
+  output_.push_back({frame, readyUs});
+}
+
+void Pn532Emulator::respondError(uint64_t readyUs) {
+  // Application level error frame: syntax error
+  const uint8_t frame[] = {0x00, 0x00, 0xFF, 0x01, 0xFF, 0x7F, 0x81, 0x00};
+  output_.push_back({std::vector<uint8_t>(frame, frame + sizeof(frame)), readyUs});
+}
@@ -0,0 +1,99 @@
+#ifndef PN532_EMULATOR_H
+#define PN532_EMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "ntag.h"
+#include "sim.h"
+
+// Byte-level PN532 on SPI: the host selects the chip, sends an SPI operation
+// byte (DATA WRITE, STATUS READ, DATA READ) and clocks frames in or out.
+// Frames are checked like the real chip does (start code, LEN/LCS, TFI, DCS),
+// valid ones are ACKed and the response becomes readable once the simulated
+// command has finished on the virtual clock.
+
+// Command timing in virtual microseconds
+struct Pn532Timing {
+  uint32_t spiByteUs = 8;          // 1 MHz SPI clock
+  uint32_t ackUs = 500;            // Frame received until ACK is ready
+  uint32_t commandUs = 1000;       // Firmware processing per command
+  uint32_t pollAttemptUs = 4700;   // One InListPassiveTarget polling attempt
+  uint32_t activationUs = 5000;    // REQA, anticollision for a 7-byte UID, SELECT
+  uint32_t rfByteUs = 94;          // 106 kbit/s incl. parity and framing
+  uint32_t rfTurnaroundUs = 400;   // Frame delay time and PN532 overhead per exchange
+  uint32_t eepromWriteUs = 4100;   // NTAG page programming
+  uint32_t rfTimeoutUs = 51200;    // fRetryTimeout default: tag did not answer
+};
+
+struct Pn532Stats {
+  uint32_t frames = 0;
+  uint32_t frameErrors = 0;        // Bad checksums or framing, silently dropped like the chip does
+  uint32_t aborts = 0;             // Command cancelled by a new frame before its response was read
+  uint32_t rfExchanges = 0;
+  uint32_t rfFailures = 0;         // Tag left the field during an exchange
+  uint32_t tornWrites = 0;         // Tag left while a WRITE was programming
+};
+
+class Pn532Emulator {
+ public:
+  explicit Pn532Emulator(SimAntenna* antenna = nullptr) : antenna_(antenna) {}
+
+  void setAntenna(SimAntenna* antenna) { antenna_ = antenna; }
+  Pn532Timing& timing() { return timing_; }
+  const Pn532Stats& stats() const { return stats_; }
+
+  // SPI bus side
+  void select();
+  void deselect();
+  uint8_t transfer(uint8_t mosi);
+
+ private:
+  struct OutputFrame {
+    std::vector<uint8_t> bytes;
+    uint64_t readyUs;
+  };
+
+  // SPI operation byte sent after selecting the chip
+  static const uint8_t SPI_OP_DATA_WRITE = 0x01;
+  static const uint8_t SPI_OP_STATUS_READ = 0x02;
+  static const uint8_t SPI_OP_DATA_READ = 0x03;
+
+  enum SpiOperation {
+    SPI_IDLE,
+    SPI_PENDING_OPERATION,
+    SPI_DATA_WRITE,
+    SPI_STATUS_READ,
+    SPI_DATA_READ
+  };
+
+  void update(uint64_t nowUs);
+  void handleFrame();
+  void execute(const uint8_t* data, size_t length, uint64_t startUs);
+  void inDataExchange(const uint8_t* data, size_t length, uint64_t startUs);
+  void respond(const uint8_t* data, size_t length, uint64_t readyUs);
+  void respondError(uint64_t readyUs);
+
+  SimAntenna* antenna_;
+  Pn532Timing timing_;
+  Pn532Stats stats_;
+
+  SpiOperation operation_ = SPI_IDLE;
+  std::vector<uint8_t> input_;
+  std::deque<OutputFrame> output_;
+  size_t readOffset_ = 0;
+
+  uint8_t maxRetries_ = 0xFF;
+
+  // InListPassiveTarget in progress
+  bool polling_ = false;
+  uint64_t pollStartUs_ = 0;
+  uint32_t pollAttempts_ = 0;
+
+  NtagTag* target_ = nullptr;      // Selected target (Tg 1)
+  uint64_t targetContactUs_ = 0;   // Tag known to be powered since then
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <cstdint>
+#include <vector>
+
+#include "ntag.h"
+
+// RF field model for the host build. Each emulated PN532 has an antenna that
+// decides which tag, if any, is in its field at a given virtual time.
+
+class SimAntenna {
+ public:
+  virtual ~SimAntenna() {}
+  virtual NtagTag* tagInField(uint64_t nowUs) = 0;
+
+  // The tag stayed powered over the whole interval. The default samples both
+  // ends, which is exact for antennas whose tags arrive and leave only once.
+  virtual bool presentThroughout(NtagTag* tag, uint64_t fromUs, uint64_t toUs) {
+    return tagInField(fromUs) == tag && tagInField(toUs) == tag;
+  }
+};
+
+// Scripted presence windows: a tag is in the field from `fromUs` for `dwellUs`
+class TapSchedule : public SimAntenna {
+ public:
+  struct Window {
+    NtagTag* tag;
+    uint64_t fromUs;
+    uint64_t dwellUs;
+  };
+
+  void add(NtagTag* tag, uint64_t fromUs, uint64_t dwellUs) { windows_.push_back({tag, fromUs, dwellUs}); }
+  void clear() { windows_.clear(); }
+
+  NtagTag* tagInField(uint64_t nowUs) override {
+    for (const Window& window : windows_) {
+      if (nowUs >= window.fromUs && nowUs < window.fromUs + window.dwellUs) return window.tag;
+    }
+    return nullptr;
+  }
+
+  bool presentThroughout(NtagTag* tag, uint64_t fromUs, uint64_t toUs) override {
+    for (const Window& window : windows_) {
+      if (window.tag == tag && fromUs >= window.fromUs && toUs < window.fromUs + window.dwellUs) return true;
+    }
+    return false;
+  }
+
+ private:
+  std::vector<Window> windows_;
+};
+
+// Virtual clock
+uint64_t simMicros();
+void simAdvance(uint64_t us);
+
+// Called on every tone(), which is how a runner knows the tap registered
+void simSetToneHook(void (*hook)(unsigned int frequency, unsigned long duration));
+
+class Pn532Emulator;
+
+// Route SPI traffic for a slave select pin to an emulated PN532
+void simAttachPn532(uint8_t ssPin, Pn532Emulator* pn532);
+Pn532Emulator* simPn532(uint8_t ssPin);
+
+#endif
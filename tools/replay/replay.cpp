@@ -0,0 +1,143 @@
+// Flight recorder replay
+//
+//   kor-replay [--corpus DIR] [FILE]...
+//
+// Reads the "FR,..." lines of a `flightrec` console dump from the files or
+// stdin and feeds the raw page data of each record through the firmware's
+// parseNdefRecord() again, built with debug logging, so a tag that failed in
+// the field can be stepped through on the host. Other lines are ignored.
+// With --corpus every record's data is also written to DIR/fr-<sequence>.bin,
+// ready to seed a fuzzer.
+
+#include <Arduino.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "flightrec.h"
+#include "nfc.h"
+#include "pn532_emulator.h"
+#include "sim.h"
+
+void setup();
+
+namespace {
+
+struct Replayed {
+  std::string sequence;
+  std::string reason;
+  std::string uid;
+  std::vector<uint8_t> data;
+};
+
+bool parseHex(const std::string& text, std::vector<uint8_t>& bytes) {
+  if (text.size() % 2 != 0) return false;
+  bytes.clear();
+  for (size_t i = 0; i < text.size(); i += 2) {
+    char pair[3] = { text[i], text[i + 1], '\0' };
+    char* end;
+    unsigned long value = strtoul(pair, &end, 16);
+    if (*end != '\0') return false;
+    bytes.push_back((uint8_t)value);
+  }
+  return true;
+}
+
+// FR,<sequence>,<time>,<reader>,<uid>,<reason>,<page>,<cc>,<length>,<data>
+bool parseRecord(const std::string& line, Replayed& record) {
+  std::vector<std::string> fields;
+  std::stringstream in(line);
+  std::string field;
+  while (std::getline(in, field, ',')) fields.push_back(field);
+  if (fields.size() != 10 || fields[0] != "FR") return false;
+
+  record.sequence = fields[1];
+  record.uid = fields[4];
+  record.reason = fields[5];
+  return parseHex(fields[9], record.data) && record.data.size() == strtoul(fields[8].c_str(), nullptr, 10) &&
+         record.data.size() <= FLIGHT_DATA_SIZE;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* corpus = nullptr;
+  std::vector<const char*> files;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) {
+      corpus = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+      fprintf(stderr, "Usage: %s [--corpus DIR] [FILE]...\n", argv[0]);
+      return 1;
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) files.push_back("-");
+
+  // A reader without a tag, for records that make the firmware talk to one
+  Pn532Emulator pn532;
+  simAttachPn532(PN532_SS, &pn532);
+  Serial.setMuted(true);
+  setup();
+  Serial.setMuted(false);
+
+  size_t replayed = 0;
+  size_t parsed = 0;
+  size_t malformed = 0;
+  for (const char* file : files) {
+    std::stringstream contents;
+    if (strcmp(file, "-") == 0) {
+      contents << std::cin.rdbuf();
+    } else {
+      std::ifstream in(file);
+      if (!in) {
+        fprintf(stderr, "Cannot open %s\n", file);
+        return 1;
+      }
+      contents << in.rdbuf();
+    }
+
+    std::string line;
+    while (std::getline(contents, line)) {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (line.compare(0, 3, "FR,") != 0) continue;
+
+      Replayed record;
+      if (!parseRecord(line, record)) {
+        fprintf(stderr, "%s: malformed record: %.40s...\n", file, line.c_str());
+        malformed++;
+        continue;
+      }
+
+      printf("== record %s, %s, tag %s, %zu bytes\n", record.sequence.c_str(), record.reason.c_str(),
+             record.uid.c_str(), record.data.size());
+      fflush(stdout);
+      // parseNdefRecord() needs a few bytes past the TLVs it looks at
+      bool ok = record.data.size() > 6 && parseNdefRecord(record.data.data(), record.data.size());
+      printf("== record %s: %s\n\n", record.sequence.c_str(), ok ? "parsed" : "rejected");
+      replayed++;
+      if (ok) parsed++;
+
+      if (corpus) {
+        std::string path = std::string(corpus) + "/fr-" + record.sequence + ".bin";
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(record.data.data()), record.data.size());
+        if (!out) {
+          fprintf(stderr, "Cannot write %s\n", path.c_str());
+          return 1;
+        }
+      }
+    }
+  }
+
+  fprintf(stderr, "Replayed %zu records, %zu parsed, %zu rejected, %zu malformed\n", replayed, parsed,
+          replayed - parsed, malformed);
+  return malformed ? 2 : 0;
+}
@@ -0,0 +1,275 @@
+#include "http.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace kor {
+
+namespace {
+
+const size_t MAX_REQUEST_SIZE = 4 * 1024 * 1024;  // Bulk imports arrive as one body
+
+struct Connection {
+  int fd;
+  std::string in;
+  std::string out;
+  size_t outOffset = 0;
+  bool closeAfterWrite = false;
+  bool peerClosed = false;  // The client shut down its side, only the answer is left to send
+};
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+const char* statusText(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    default: return "Internal Server Error";
+  }
+}
+
+bool headerEquals(std::string_view headers, std::string_view name, std::string_view value) {
+  size_t pos = 0;
+  while ((pos = headers.find("\r\n", pos)) != std::string_view::npos) {
+    pos += 2;
+    if (headers.size() - pos < name.size() + 1) break;
+    if (strncasecmp(headers.data() + pos, name.data(), name.size()) != 0 || headers[pos + name.size()] != ':') continue;
+    size_t start = pos + name.size() + 1;
+    while (start < headers.size() && headers[start] == ' ') start++;
+    return headers.size() - start >= value.size() &&
+           strncasecmp(headers.data() + start, value.data(), value.size()) == 0;
+  }
+  return false;
+}
+
+size_t contentLength(std::string_view headers) {
+  const char name[] = "\r\ncontent-length:";
+  for (size_t pos = 0; pos + sizeof(name) - 1 <= headers.size(); pos++) {
+    if (strncasecmp(headers.data() + pos, name, sizeof(name) - 1) == 0) {
+      return strtoul(headers.data() + pos + sizeof(name) - 1, nullptr, 10);
+    }
+  }
+  return 0;
+}
+
+void appendResponse(Connection& connection, const HttpResponse& response) {
+  char header[256];
+  int length = snprintf(header, sizeof(header),
+                        "HTTP/1.1 %d %s\r\n"
+                        "Content-Type: %s\r\n"
+                        "Content-Length: %zu\r\n"
+                        "Access-Control-Allow-Origin: *\r\n"
+                        "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
+                        "Access-Control-Allow-Headers: Content-Type\r\n"
+                        "Cache-Control: no-store\r\n"
+                        "%s\r\n",
+                        response.status, statusText(response.status), response.contentType,
+                        response.body.size(), connection.closeAfterWrite ? "Connection: close\r\n" : "");
+  connection.out.append(header, length);
+  connection.out += response.body;
+}
+
+// Parse and answer every complete request in the input buffer
+void processInput(Connection& connection, const HttpHandler& handler) {
+  size_t consumed = 0;
+  if (connection.closeAfterWrite) {
+    connection.in.clear();  // Anything after the last answered request is dropped
+    return;
+  }
+  while (!connection.closeAfterWrite) {
+    std::string_view pending(connection.in.data() + consumed, connection.in.size() - consumed);
+    size_t headerEnd = pending.find("\r\n\r\n");
+    size_t bodyLength = 0;
+    if (headerEnd != std::string_view::npos) bodyLength = contentLength(pending.substr(0, headerEnd + 2));
+
+    // The connection closes once the 413 is out, so the rest is never read
+    if ((headerEnd == std::string_view::npos && pending.size() > MAX_REQUEST_SIZE) ||
+        bodyLength > MAX_REQUEST_SIZE) {
+      HttpResponse response;
+      response.status = 413;
+      connection.closeAfterWrite = true;
+      appendResponse(connection, response);
+      consumed = connection.in.size();
+      break;
+    }
+    if (headerEnd == std::string_view::npos) break;
+
+    std::string_view headers = pending.substr(0, headerEnd + 2);
+    if (pending.size() < headerEnd + 4 + bodyLength) break;
+
+    HttpRequest request;
+    std::string_view requestLine = headers.substr(0, headers.find("\r\n"));
+    size_t methodEnd = requestLine.find(' ');
+    size_t targetEnd = requestLine.find(' ', methodEnd + 1);
+    HttpResponse response;
+    if (methodEnd == std::string_view::npos || targetEnd == std::string_view::npos) {
+      response.status = 400;
+      connection.closeAfterWrite = true;
+    } else {
+      request.method = requestLine.substr(0, methodEnd);
+      std::string_view target = requestLine.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+      size_t queryStart = target.find('?');
+      request.path = target.substr(0, queryStart);
+      if (queryStart != std::string_view::npos) request.query = target.substr(queryStart + 1);
+      request.body = pending.substr(headerEnd + 4, bodyLength);
+
+      if (headerEquals(headers, "Connection", "close")) connection.closeAfterWrite = true;
+      if (request.method == "OPTIONS") {
+        response.status = 204;
+      } else {
+        handler(request, response);
+      }
+    }
+    appendResponse(connection, response);
+    consumed += headerEnd + 4 + bodyLength;
+  }
+  connection.in.erase(0, consumed);
+}
+
+// Returns false once the connection should be dropped
+bool flushOutput(Connection& connection) {
+  while (connection.outOffset < connection.out.size()) {
+    ssize_t written = send(connection.fd, connection.out.data() + connection.outOffset,
+                           connection.out.size() - connection.outOffset, MSG_NOSIGNAL);
+    if (written < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    connection.outOffset += written;
+  }
+  connection.out.clear();
+  connection.outOffset = 0;
+  return !connection.closeAfterWrite;
+}
+
+}  // namespace
+
+bool findParam(std::string_view params, std::string_view name, std::string& value) {
+  while (!params.empty()) {
+    size_t end = params.find('&');
+    std::string_view pair = params.substr(0, end);
+    params = end == std::string_view::npos ? std::string_view() : params.substr(end + 1);
+
+    size_t eq = pair.find('=');
+    if (pair.substr(0, eq) != name) continue;
+
+    value.clear();
+    if (eq == std::string_view::npos) return true;
+    std::string_view encoded = pair.substr(eq + 1);
+    for (size_t i = 0; i < encoded.size(); i++) {
+      if (encoded[i] == '+') {
+        value += ' ';
+      } else if (encoded[i] == '%' && i + 2 < encoded.size() && hexValue(encoded[i + 1]) >= 0 &&
+                 hexValue(encoded[i + 2]) >= 0) {
+        value += (char)(hexValue(encoded[i + 1]) * 16 + hexValue(encoded[i + 2]));
+        i += 2;
+      } else {
+        value += encoded[i];
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+bool runHttpServer(uint16_t port, const HttpHandler& handler) {
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener < 0) return false;
+
+  int enable = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (bind(listener, (sockaddr*)&address, sizeof(address)) < 0 || listen(listener, 128) < 0) {
+    close(listener);
+    return false;
+  }
+  fcntl(listener, F_SETFL, O_NONBLOCK);
+
+  std::vector<Connection> connections;
+  std::vector<pollfd> fds;
+  char buffer[16384];
+
+  while (true) {
+    fds.clear();
+    fds.push_back({listener, POLLIN, 0});
+    for (const Connection& connection : connections) {
+      short events = connection.peerClosed ? 0 : POLLIN;
+      if (!connection.out.empty()) events |= POLLOUT;
+      fds.push_back({connection.fd, events, 0});
+    }
+
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+
+    // Walk backwards so closed connections can be removed in place
+    for (size_t i = connections.size(); i-- > 0;) {
+      Connection& connection = connections[i];
+      short revents = fds[i + 1].revents;
+      bool keep = true;
+
+      if (revents & (POLLERR | POLLNVAL)) {
+        keep = false;
+      } else if (revents & (POLLIN | POLLHUP)) {
+        ssize_t received;
+        while ((received = recv(connection.fd, buffer, sizeof(buffer), 0)) > 0) {
+          connection.in.append(buffer, received);
+        }
+        if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+          keep = false;
+        } else {
+          processInput(connection, handler);
+          // A client that half-closes after its request still gets the answer
+          if (received == 0) {
+            connection.peerClosed = true;
+            connection.closeAfterWrite = true;
+            keep = !connection.out.empty();
+          }
+        }
+      }
+
+      if (keep && !connection.out.empty()) keep = flushOutput(connection);
+
+      if (!keep) {
+        close(connection.fd);
+        connections[i] = std::move(connections.back());
+        connections.pop_back();
+      }
+    }
+
+    if (fds[0].revents & POLLIN) {
+      int fd;
+      while ((fd = accept(listener, nullptr, nullptr)) >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        connections.push_back({fd, std::string(), std::string()});
+      }
+    }
+  }
+}
+
+}  // namespace kor
@@ -0,0 +1,37 @@
+#ifndef HTTP_H
+#define HTTP_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Minimal single-threaded HTTP/1.1 server: non-blocking sockets, poll(),
+// keep-alive and pipelining. Enough for a results tent on a local network.
+
+namespace kor {
+
+struct HttpRequest {
+  std::string_view method;
+  std::string_view path;
+  std::string_view query;
+  std::string_view body;
+};
+
+struct HttpResponse {
+  int status = 200;
+  const char* contentType = "application/json";
+  std::string body;
+};
+
+using HttpHandler = std::function<void(const HttpRequest&, HttpResponse&)>;
+
+// Look up a parameter in a query string or form-encoded body, URL-decoded
+bool findParam(std::string_view params, std::string_view name, std::string& value);
+
+// Runs until the process is terminated. Returns false if the port cannot be bound.
+bool runHttpServer(uint16_t port, const HttpHandler& handler);
+
+}  // namespace kor
+
+#endif
@@ -0,0 +1,207 @@
+// Load generator for kor-results
+//
+//   kor-loadgen [--host 127.0.0.1] [--port 8080] [--connections 8] [--requests 20000]
+//               [--runners 500] [--in-process]
+//
+// Posts synthetic readout payloads over keep-alive connections and reports
+// ingest throughput and latency percentiles. --in-process skips HTTP and
+// measures ResultStore::ingest() alone.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "press_table.h"
+#include "store.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  const char* host = "127.0.0.1";
+  uint16_t port = 8080;
+  unsigned connections = 8;
+  unsigned requests = 20000;
+  unsigned runners = 500;
+  bool inProcess = false;
+};
+
+// A runner's dump as the firmware would produce it, with a mix of clean runs,
+// mispunches and unfinished races
+std::string syntheticPayload(std::mt19937& rng, uint8_t courseLength) {
+  kor::PressTable table;
+  table.courseLength = courseLength;
+  table.presses.push_back({0, 0});
+
+  uint32_t time = 0;
+  std::uniform_int_distribution<uint32_t> leg(60000, 600000);
+  std::uniform_int_distribution<int> chance(0, 99);
+  for (uint8_t control = 1; control <= courseLength; control++) {
+    if (chance(rng) < 3) {
+      time += leg(rng);
+      table.presses.push_back({(uint8_t)(control + 1), time});  // Mispunch
+    }
+    time += leg(rng);
+    table.presses.push_back({control, time});
+  }
+  if (chance(rng) < 95) {
+    time += leg(rng) / 4;
+    table.presses.push_back({99, time});
+  }
+  return kor::encodePressTable(table);
+}
+
+int connectTo(const Options& options) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.port);
+  inet_pton(AF_INET, options.host, &address.sin_addr);
+  if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+    if (fd >= 0) close(fd);
+    return -1;
+  }
+  int enable = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  return fd;
+}
+
+// Send one request and read one response; returns false on a transport error
+bool roundTrip(int fd, const std::string& request, std::string& buffer) {
+  size_t sent = 0;
+  while (sent < request.size()) {
+    ssize_t written = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+    if (written <= 0) return false;
+    sent += written;
+  }
+
+  buffer.clear();
+  char chunk[4096];
+  while (true) {
+    size_t headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd != std::string::npos) {
+      size_t lengthPos = buffer.find("Content-Length: ");
+      size_t length = lengthPos < headerEnd ? strtoul(buffer.c_str() + lengthPos + 16, nullptr, 10) : 0;
+      if (buffer.size() >= headerEnd + 4 + length) return buffer.compare(9, 3, "200") == 0;
+    }
+    ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+    if (received <= 0) return false;
+    buffer.append(chunk, received);
+  }
+}
+
+void report(const char* label, std::vector<double>& latencies, double seconds, unsigned failures) {
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))];
+  };
+  printf("%s: %zu ingests in %.3f s = %.0f ingests/s, %u failed\n", label, latencies.size(), seconds,
+         latencies.size() / seconds, failures);
+  printf("  latency p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us\n", percentile(0.5), percentile(0.9),
+         percentile(0.99), latencies.empty() ? 0.0 : latencies.back());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+      options.host = argv[++i];
+    } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+      options.port = (uint16_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--connections") == 0 && i + 1 < argc) {
+      options.connections = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+      options.requests = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--runners") == 0 && i + 1 < argc) {
+      options.runners = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--in-process") == 0) {
+      options.inProcess = true;
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--host H] [--port N] [--connections N] [--requests N] [--runners N] [--in-process]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  // Pre-generate payloads so the generator does not limit throughput. Each
+  // runner re-reads several times during the race, so later dumps update
+  // earlier entries just like live readouts do.
+  std::mt19937 rng(42);
+  std::vector<std::string> payloads(options.requests);
+  for (unsigned i = 0; i < options.requests; i++) {
+    payloads[i] = syntheticPayload(rng, 5 + (i % options.runners) % 3 * 5);
+  }
+
+  if (options.inProcess) {
+    kor::ResultStore store;
+    std::vector<double> latencies;
+    latencies.reserve(options.requests);
+    Clock::time_point start = Clock::now();
+    for (unsigned i = 0; i < options.requests; i++) {
+      std::string runner = "runner-" + std::to_string(i % options.runners);
+      Clock::time_point before = Clock::now();
+      store.ingest("", runner, payloads[i]);
+      latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - before).count());
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    report("in-process", latencies, seconds, 0);
+    return 0;
+  }
+
+  std::vector<std::vector<double>> latencies(options.connections);
+  std::atomic<unsigned> next(0);
+  std::atomic<unsigned> failures(0);
+  std::vector<std::thread> workers;
+
+  Clock::time_point start = Clock::now();
+  for (unsigned c = 0; c < options.connections; c++) {
+    workers.emplace_back([&, c]() {
+      int fd = connectTo(options);
+      if (fd < 0) {
+        failures++;
+        return;
+      }
+      std::string request, response;
+      unsigned i;
+      while ((i = next++) < options.requests) {
+        std::string body = "runner=runner-" + std::to_string(i % options.runners) + "&table=" + payloads[i];
+        request = "POST /api/ingest HTTP/1.1\r\nHost: kor\r\n"
+                  "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: " +
+                  std::to_string(body.size()) + "\r\n\r\n" + body;
+        Clock::time_point before = Clock::now();
+        if (!roundTrip(fd, request, response)) {
+          failures++;
+          close(fd);
+          if ((fd = connectTo(options)) < 0) return;
+          continue;
+        }
+        latencies[c].push_back(std::chrono::duration<double, std::micro>(Clock::now() - before).count());
+      }
+      close(fd);
+    });
+  }
+  for (std::thread& worker : workers) worker.join();
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::vector<double> all;
+  for (const auto& perConnection : latencies) all.insert(all.end(), perConnection.begin(), perConnection.end());
+  report("http", all, seconds, failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+// KOR results aggregation service
+//
+// Collects readout payloads (the ?table= parameter written by
+// processReadoutTrigger()) and serves live rankings and split tables.
+//
+//   kor-results [--port 8080] [--mac-key HEX] [--import dumps.tsv]...
+//
+// With --mac-key (the stations' READOUT_MAC_KEY as 32 hex digits) only
+// dumps carrying a valid "&m=" MAC are accepted.
+//
+//   POST /api/ingest   table=<payload or dump URL>&m=<mac>&runner=<name>&course=<name>
+//   POST /api/import   one dump per line, see ResultStore::importLines()
+//   GET  /api/courses
+//   GET  /api/results?course=<name>
+//   GET  /api/splits?course=<name>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "http.h"
+#include "store.h"
+
+namespace {
+
+const char INDEX_HTML[] = R"HTML(<!DOCTYPE html>
+<html lang="cs">
+<head>
+<meta charset="UTF-8">
+<meta name="viewport" content="width=device-width, initial-scale=1.0">
+<title>KOR - Výsledky</title>
+<style>
+body{font-family:-apple-system,'Segoe UI',Roboto,Arial,sans-serif;margin:0;padding:20px;color:#333;background:#f8f9fa}
+h1{margin:0 0 16px;color:#2c3e50}
+table{border-collapse:collapse;background:#fff;margin:12px 0 24px;min-width:320px}
+th,td{text-align:left;padding:6px 12px;border-bottom:1px solid #e9ecef}
+th{background:#eef1f4;font-size:.85rem;text-transform:uppercase}
+.time{font-family:'Courier New',monospace}
+.disqualified td{color:#c62828}
+.best{font-weight:bold;color:#2e7d32}
+textarea{width:100%;max-width:640px;height:4em}
+</style>
+</head>
+<body>
+<h1>KOR - Výsledky</h1>
+<form id="paste">
+<input id="runner" placeholder="Závodník">
+<input id="course" placeholder="Trať (volitelné)"><br>
+<textarea id="table" placeholder="Vložte odkaz z vyčítací karty"></textarea><br>
+<button>Přidat</button> <span id="paste-status"></span>
+</form>
+<p>Trať: <select id="courses"></select> <span id="ingested"></span></p>
+<table><thead><tr><th>Pořadí</th><th>Závodník</th><th>Čas</th><th>Ztráta</th><th>Kontroly</th><th>Stav</th></tr></thead><tbody id="results"></tbody></table>
+<table><thead id="splits-head"></thead><tbody id="splits"></tbody></table>
+<script>
+const STATUS = { finished: 'Dokončeno', running: 'Probíhá', disqualified: 'Diskvalifikace' };
+const fmt = ms => { const s = Math.floor(ms / 1000); return `${String(Math.floor(s / 60)).padStart(2, '0')}:${String(s % 60).padStart(2, '0')}.${String(ms % 1000).padStart(3, '0')}`; };
+const cell = (row, text, cls) => { const td = row.insertCell(); td.textContent = text; if (cls) td.className = cls; return td; };
+const select = document.getElementById('courses');
+
+async function refresh() {
+  const courses = await (await fetch('api/courses')).json();
+  document.getElementById('ingested').textContent = `(${courses.ingested} vyčtení)`;
+  const selected = select.value;
+  select.replaceChildren(...courses.courses.map(c => new Option(`${c.name} (${c.runners})`, c.name)));
+  if (selected) select.value = selected;
+  if (!select.value) return;
+
+  const course = encodeURIComponent(select.value);
+  const results = await (await fetch(`api/results?course=${course}`)).json();
+  const body = document.getElementById('results');
+  body.replaceChildren();
+  for (const r of results.results) {
+    const row = body.insertRow();
+    if (r.status === 'disqualified') row.className = 'disqualified';
+    cell(row, r.rank ?? '-');
+    cell(row, r.runner);
+    cell(row, fmt(r.time), 'time');
+    cell(row, r.behind !== undefined ? '+' + fmt(r.behind) : '-', 'time');
+    cell(row, `${r.visited}/${results.courseLength + 2}`);
+    cell(row, STATUS[r.status]);
+  }
+
+  const splits = await (await fetch(`api/splits?course=${course}`)).json();
+  const head = document.getElementById('splits-head');
+  const runners = results.results.map(r => r.runner);
+  head.replaceChildren();
+  const headRow = head.insertRow();
+  cell(headRow, 'Úsek');
+  runners.forEach(name => cell(headRow, name));
+  const sbody = document.getElementById('splits');
+  sbody.replaceChildren();
+  for (const control of splits.controls) {
+    const row = sbody.insertRow();
+    cell(row, control.control === 99 ? 'Cíl' : `Kontrola ${control.control}`);
+    const byRunner = new Map(control.splits.map(s => [s.runner, s]));
+    for (const name of runners) {
+      const s = byRunner.get(name);
+      cell(row, s ? `${fmt(s.split)} (${s.rank})` : '-', s && s.split === control.best ? 'time best' : 'time');
+    }
+  }
+}
+
+document.getElementById('paste').addEventListener('submit', async e => {
+  e.preventDefault();
+  const form = new URLSearchParams();
+  for (const id of ['table', 'runner', 'course']) form.set(id, document.getElementById(id).value.trim());
+  const reply = await (await fetch('api/ingest', { method: 'POST', body: form })).json();
+  document.getElementById('paste-status').textContent = reply.result;
+  if (reply.result !== 'invalid') document.getElementById('table').value = '';
+  refresh();
+});
+select.addEventListener('change', refresh);
+refresh();
+setInterval(refresh, 5000);
+</script>
+</body>
+</html>
+)HTML";
+
+const char* ingestResultName(kor::IngestResult result) {
+  switch (result) {
+    case kor::IngestResult::Added: return "added";
+    case kor::IngestResult::Updated: return "updated";
+    case kor::IngestResult::Duplicate: return "duplicate";
+    case kor::IngestResult::Unverified: return "unverified";
+    default: return "invalid";
+  }
+}
+
+void handleRequest(kor::ResultStore& store, const kor::HttpRequest& request, kor::HttpResponse& response) {
+  std::string value;
+
+  if (request.method == "GET" && (request.path == "/" || request.path == "/index.html")) {
+    response.contentType = "text/html; charset=utf-8";
+    response.body.assign(INDEX_HTML, sizeof(INDEX_HTML) - 1);
+  } else if (request.method == "GET" && request.path == "/api/courses") {
+    response.body = store.coursesJson();
+  } else if (request.method == "GET" && (request.path == "/api/results" || request.path == "/api/splits")) {
+    const kor::Course* course = kor::findParam(request.query, "course", value) ? store.course(value) : nullptr;
+    if (!course) {
+      response.status = 404;
+      response.body = "{\"error\":\"unknown course\"}";
+    } else {
+      response.body = request.path == "/api/results" ? course->resultsJson() : course->splitsJson();
+    }
+  } else if (request.method == "POST" && request.path == "/api/ingest") {
+    // Parameters may come in the query string, a form body or a bare payload body
+    std::string table, mac, runner, course;
+    if (!kor::findParam(request.query, "table", table) && !kor::findParam(request.body, "table", table)) {
+      table.assign(request.body);
+    }
+    // The MAC as a separate parameter rather than inside a pasted URL
+    if (kor::findParam(request.query, "m", mac) || kor::findParam(request.body, "m", mac)) {
+      table += KOR_MAC_PARAM + mac;
+    }
+    if (!kor::findParam(request.query, "runner", runner)) kor::findParam(request.body, "runner", runner);
+    if (!kor::findParam(request.query, "course", course)) kor::findParam(request.body, "course", course);
+
+    kor::IngestResult result = store.ingest(course, runner, table);
+    if (result == kor::IngestResult::Invalid) response.status = 400;
+    if (result == kor::IngestResult::Unverified) response.status = 403;
+    response.body = std::string("{\"result\":\"") + ingestResultName(result) + "\"}";
+  } else if (request.method == "POST" && request.path == "/api/import") {
+    response.body = "{\"accepted\":" + std::to_string(store.importLines(request.body)) + "}";
+  } else {
+    response.status = 404;
+    response.body = "{\"error\":\"not found\"}";
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint16_t port = 8080;
+  kor::ResultStore store;
+
+  std::vector<const char*> imports;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+      port = (uint16_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--mac-key") == 0 && i + 1 < argc) {
+      uint8_t key[kor::MAC_KEY_SIZE];
+      if (!kor::parseMacKey(argv[++i], key)) {
+        fprintf(stderr, "The MAC key is 32 hex digits\n");
+        return 1;
+      }
+      store.setMacKey(key);
+    } else if (strcmp(argv[i], "--import") == 0 && i + 1 < argc) {
+      imports.push_back(argv[++i]);
+    } else {
+      fprintf(stderr, "Usage: %s [--port N] [--mac-key HEX] [--import FILE]...\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // Only after all options, so a --mac-key anywhere on the line checks every import
+  for (const char* path : imports) {
+    std::ifstream file(path);
+    if (!file) {
+      fprintf(stderr, "Cannot open %s\n", path);
+      return 1;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    size_t accepted = store.importLines(contents.str());
+    printf("Imported %zu dumps from %s\n", accepted, path);
+  }
+
+  printf("KOR results service listening on port %u\n", port);
+  fflush(stdout);
+  if (!kor::runHttpServer(port, [&store](const kor::HttpRequest& request, kor::HttpResponse& response) {
+        handleRequest(store, request, response);
+      })) {
+    fprintf(stderr, "Cannot listen on port %u\n", port);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,243 @@
+#include "store.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace kor {
+
+uint64_t hashPayload(const uint8_t* data, size_t length) {
+  // FNV-1a, 64 bit
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+void appendJsonString(std::string& out, std::string_view text) {
+  out += '"';
+  for (char c : text) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          char escaped[8];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+          out += escaped;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+Course::RankKey Course::rankKey(const RunnerResult& result, uint32_t index) {
+  return RankKey((uint8_t)result.analysis.status, result.analysis.totalTime, index);
+}
+
+void Course::unindex(uint32_t index) {
+  const RunnerResult& result = runners_[index];
+  ranking_.erase(rankKey(result, index));
+  for (const auto& leg : result.legs) {
+    auto it = legs_[leg.first].find({leg.second, index});
+    if (it != legs_[leg.first].end()) legs_[leg.first].erase(it);
+  }
+}
+
+void Course::index(uint32_t index) {
+  RunnerResult& result = runners_[index];
+  result.legs.clear();
+  for (size_t i = 0; i < result.table.presses.size(); i++) {
+    uint8_t checkpoint = result.table.presses[i].checkpoint;
+    if (checkpoint == 0 || checkpoint > 99 || result.analysis.splits[i] < 0) continue;
+    result.legs.emplace_back(checkpoint, (uint32_t)result.analysis.splits[i]);
+    legs_[checkpoint].insert({(uint32_t)result.analysis.splits[i], index});
+  }
+  ranking_.insert(rankKey(result, index));
+}
+
+IngestResult Course::ingest(const std::string& runner, uint64_t payloadHash, PressTable&& table) {
+  if (courseLength_ == 0) courseLength_ = table.courseLength;
+
+  auto found = byRunner_.find(runner);
+  uint32_t index;
+  IngestResult outcome;
+  if (found == byRunner_.end()) {
+    index = runners_.size();
+    runners_.emplace_back();
+    runners_[index].runner = runner;
+    byRunner_.emplace(runner, index);
+    outcome = IngestResult::Added;
+  } else {
+    index = found->second;
+    if (runners_[index].payloadHash == payloadHash) return IngestResult::Duplicate;
+    unindex(index);
+    outcome = IngestResult::Updated;
+  }
+
+  RunnerResult& result = runners_[index];
+  result.payloadHash = payloadHash;
+  result.table = std::move(table);
+  result.analysis = analysePressTable(result.table);
+  this->index(index);
+  return outcome;
+}
+
+std::string Course::resultsJson() const {
+  std::string out;
+  out.reserve(64 + ranking_.size() * 96);
+  out += "{\"course\":";
+  appendJsonString(out, name_);
+  out += ",\"courseLength\":" + std::to_string(courseLength_) + ",\"results\":[";
+
+  uint32_t rank = 0;
+  uint32_t winnerTime = 0;
+  bool first = true;
+  for (const RankKey& key : ranking_) {
+    const RunnerResult& result = runners_[std::get<2>(key)];
+    bool finished = result.analysis.status == RaceStatus::Finished;
+    if (finished && rank == 0) winnerTime = result.analysis.totalTime;
+
+    if (!first) out += ',';
+    first = false;
+    out += "{\"rank\":";
+    out += finished ? std::to_string(++rank) : "null";
+    out += ",\"runner\":";
+    appendJsonString(out, result.runner);
+    out += ",\"status\":\"";
+    out += raceStatusName(result.analysis.status);
+    out += "\",\"time\":" + std::to_string(result.analysis.totalTime);
+    if (finished) out += ",\"behind\":" + std::to_string(result.analysis.totalTime - winnerTime);
+    out += ",\"visited\":" + std::to_string(result.analysis.visited);
+    out += ",\"presses\":" + std::to_string(result.table.presses.size()) + "}";
+  }
+  out += "]}";
+  return out;
+}
+
+std::string Course::splitsJson() const {
+  std::string out;
+  out += "{\"course\":";
+  appendJsonString(out, name_);
+  out += ",\"courseLength\":" + std::to_string(courseLength_) + ",\"controls\":[";
+
+  bool firstControl = true;
+  for (uint8_t control = 1; control <= 99; control++) {
+    if (control > courseLength_ && control != 99) continue;
+    const auto& leg = legs_[control];
+    if (leg.empty()) continue;
+
+    if (!firstControl) out += ',';
+    firstControl = false;
+    out += "{\"control\":" + std::to_string(control);
+    out += ",\"best\":" + std::to_string(leg.begin()->first) + ",\"splits\":[";
+
+    uint32_t rank = 0;
+    bool first = true;
+    for (const auto& entry : leg) {
+      if (!first) out += ',';
+      first = false;
+      out += "{\"rank\":" + std::to_string(++rank) + ",\"runner\":";
+      appendJsonString(out, runners_[entry.second].runner);
+      out += ",\"split\":" + std::to_string(entry.first) + "}";
+    }
+    out += "]}";
+  }
+  out += "]}";
+  return out;
+}
+
+IngestResult ResultStore::ingest(std::string_view course, std::string_view runner, std::string_view payload) {
+  std::vector<uint8_t> binary;
+  PressTable table;
+  if (!base64UrlDecode(extractTablePayload(payload), binary) ||
+      !parsePressTable(binary.data(), binary.size(), table)) {
+    return IngestResult::Invalid;
+  }
+  if (hasMacKey_ &&
+      verifyPressTableMac(macKey_, binary.data(), binary.size(), extractMacParam(payload)) != MacStatus::Valid) {
+    return IngestResult::Unverified;
+  }
+
+  uint64_t payloadHash = hashPayload(binary.data(), binary.size());
+
+  std::string runnerName(runner);
+  if (runnerName.empty()) {
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)payloadHash);
+    runnerName = hex;
+  }
+
+  std::string courseName(course);
+  if (courseName.empty()) courseName = "L" + std::to_string(table.courseLength);
+
+  auto it = courses_.find(courseName);
+  if (it == courses_.end()) it = courses_.emplace(courseName, Course(courseName)).first;
+
+  ingestCount_++;
+  return it->second.ingest(runnerName, payloadHash, std::move(table));
+}
+
+void ResultStore::setMacKey(const uint8_t* key) {
+  memcpy(macKey_, key, MAC_KEY_SIZE);
+  hasMacKey_ = true;
+}
+
+size_t ResultStore::importLines(std::string_view text) {
+  size_t accepted = 0;
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    std::string_view line = text.substr(0, end);
+    text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    if (line.empty() || line[0] == '#') continue;
+
+    std::string_view fields[3];
+    size_t count = 0;
+    while (count < 3) {
+      size_t tab = line.find('\t');
+      fields[count++] = line.substr(0, tab);
+      if (tab == std::string_view::npos) break;
+      line.remove_prefix(tab + 1);
+    }
+
+    IngestResult result;
+    if (count == 3) {
+      result = ingest(fields[0], fields[1], fields[2]);
+    } else if (count == 2) {
+      result = ingest("", fields[0], fields[1]);
+    } else {
+      result = ingest("", "", fields[0]);
+    }
+    if (result != IngestResult::Invalid && result != IngestResult::Unverified) accepted++;
+  }
+  return accepted;
+}
+
+const Course* ResultStore::course(const std::string& name) const {
+  auto it = courses_.find(name);
+  return it == courses_.end() ? nullptr : &it->second;
+}
+
+std::string ResultStore::coursesJson() const {
+  std::string out = "{\"courses\":[";
+  bool first = true;
+  for (const auto& entry : courses_) {
+    if (!first) out += ',';
+    first = false;
+    out += "{\"name\":";
+    appendJsonString(out, entry.first);
+    out += ",\"courseLength\":" + std::to_string(entry.second.courseLength());
+    out += ",\"runners\":" + std::to_string(entry.second.runnerCount()) + "}";
+  }
+  out += "],\"ingested\":" + std::to_string(ingestCount_) + "}";
+  return out;
+}
+
+}  // namespace kor
@@ -0,0 +1,93 @@
+#ifndef STORE_H
+#define STORE_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "press_table.h"
+
+// In-memory results store indexed by course and runner. Rankings and
+// per-control split tables are updated on every ingest, so queries never
+// re-analyse the stored dumps.
+
+namespace kor {
+
+enum class IngestResult {
+  Added,
+  Updated,
+  Duplicate,
+  Invalid,
+  Unverified  // MAC missing or wrong while a key is set
+};
+
+struct RunnerResult {
+  std::string runner;
+  uint64_t payloadHash = 0;
+  PressTable table;
+  Analysis analysis;
+  std::vector<std::pair<uint8_t, uint32_t>> legs;  // (control, split) of in-sequence presses
+};
+
+class Course {
+ public:
+  explicit Course(std::string name) : name_(std::move(name)) {}
+
+  IngestResult ingest(const std::string& runner, uint64_t payloadHash, PressTable&& table);
+
+  const std::string& name() const { return name_; }
+  size_t runnerCount() const { return runners_.size(); }
+  uint8_t courseLength() const { return courseLength_; }
+
+  std::string resultsJson() const;
+  std::string splitsJson() const;
+
+ private:
+  // Ranking order: status first, then total time, then arrival order
+  using RankKey = std::tuple<uint8_t, uint32_t, uint32_t>;
+
+  static RankKey rankKey(const RunnerResult& result, uint32_t index);
+  void unindex(uint32_t index);
+  void index(uint32_t index);
+
+  std::string name_;
+  uint8_t courseLength_ = 0;
+  std::vector<RunnerResult> runners_;
+  std::unordered_map<std::string, uint32_t> byRunner_;
+  std::set<RankKey> ranking_;
+  std::multiset<std::pair<uint32_t, uint32_t>> legs_[100];  // Per control: (split, runner index)
+};
+
+class ResultStore {
+ public:
+  // Course defaults to the course length ("L7"), runner to a hash of the payload
+  IngestResult ingest(std::string_view course, std::string_view runner, std::string_view payload);
+
+  // Bulk import, one dump per line: "[course<TAB>]runner<TAB>payload" or a bare payload/URL
+  size_t importLines(std::string_view text);
+
+  // Station MAC key: from then on only dumps with a valid MAC are accepted
+  void setMacKey(const uint8_t* key);
+
+  const Course* course(const std::string& name) const;
+  std::string coursesJson() const;
+  uint64_t ingestCount() const { return ingestCount_; }
+
+ private:
+  std::unordered_map<std::string, Course> courses_;
+  uint64_t ingestCount_ = 0;
+  bool hasMacKey_ = false;
+  uint8_t macKey_[MAC_KEY_SIZE];
+};
+
+uint64_t hashPayload(const uint8_t* data, size_t length);
+void appendJsonString(std::string& out, std::string_view text);
+
+}  // namespace kor
+
+#endif
@@ -0,0 +1,192 @@
+// Offline-first build of the results page
+//
+//   node build.mjs
+//
+// Writes dist/ for the container (Dockerfile, Caddyfile):
+//   dump.html, sw.js          whitespace and comments stripped, nothing renamed
+//   *.br, *.gz                precompressed at the highest levels, served as is
+//
+// and prints the page weight and a time-to-render estimate for a runner
+// opening a dump URL right after the readout. The network part is modelled
+// (handshakes, TCP slow start and bandwidth of the WebPageTest mobile
+// presets), so it is the same on every machine. The script part is measured:
+// the built page's own script is compiled and run on a full readout in a VM
+// context, median of RUNS. Fails if the compressed page no longer fits the
+// first round trip.
+
+import { createHash } from 'node:crypto';
+import { mkdirSync, readFileSync, writeFileSync } from 'node:fs';
+import { performance } from 'node:perf_hooks';
+import vm from 'node:vm';
+import zlib from 'node:zlib';
+
+const SOURCE = new URL('./', import.meta.url);
+const DIST = new URL('dist/', SOURCE);
+
+const MSS = 1460;
+const INITIAL_WINDOW = 10 * MSS;  // RFC 6928
+const HEADER_BYTES = 400;         // Response status line and headers
+const PAGE_BUDGET = INITIAL_WINDOW - HEADER_BYTES;
+const RUNS = 200;
+
+// WebPageTest connectivity presets: downlink bit/s, round trip ms
+const PROFILES = [
+    { name: '2G', bitsPerSecond: 280e3, rttMs: 800 },
+    { name: '3G slow', bitsPerSecond: 400e3, rttMs: 400 },
+    { name: '3G fast', bitsPerSecond: 1.6e6, rttMs: 150 }
+];
+
+// The readout image holds at most 16 presses (src/serialize.cpp)
+const SAMPLE_PRESSES = [
+    [0, 0], [1, 312450], [2, 655010], [3, 1021877], [4, 1398002], [5, 1702311], [6, 2110450], [7, 2400912],
+    [8, 2791003], [9, 3188777], [10, 3502114], [11, 3899020], [12, 4207736], [13, 4620019], [14, 4981552],
+    [99, 5230101]
+];
+
+function minifyCss(css) {
+    return css
+        .replace(/\/\*[\s\S]*?\*\//g, '')
+        .replace(/\s+/g, ' ')
+        .replace(/\s*([{}:;,>])\s*/g, '$1')
+        .replace(/;}/g, '}')
+        .trim();
+}
+
+// Only layout goes: indentation, blank lines and comments on lines of their
+// own or after a statement. Line breaks stay, so nothing depends on ASI.
+function minifyScript(script) {
+    return script
+        .split('\n')
+        .map((line) => line.trim().replace(/([;{,])\s+\/\/ .*$/, '$1'))
+        .filter((line) => line && !line.startsWith('//'))
+        .join('\n');
+}
+
+// Whitespace between tags collapses to one newline, which renders the same
+function minifyHtml(html) {
+    const blocks = [];
+    const keep = (text) => `\u0000${blocks.push(text) - 1}\u0000`;
+    return html
+        .replace(/(<style>)([\s\S]*?)(<\/style>)/g, (_, open, css, close) => keep(open + minifyCss(css) + close))
+        .replace(/(<script>)([\s\S]*?)(<\/script>)/g, (_, open, js, close) => keep(`${open}\n${minifyScript(js)}\n${close}`))
+        .replace(/<!--[\s\S]*?-->/g, '')
+        .replace(/\s*\n\s*/g, '\n')
+        .replace(/\u0000(\d+)\u0000/g, (_, index) => blocks[index])
+        .trim() + '\n';
+}
+
+function compress(data) {
+    return {
+        gzip: zlib.gzipSync(data, { level: 9 }),  // No file name or time in the header
+        brotli: zlib.brotliCompressSync(data, {
+            params: {
+                [zlib.constants.BROTLI_PARAM_MODE]: zlib.constants.BROTLI_MODE_TEXT,
+                [zlib.constants.BROTLI_PARAM_QUALITY]: zlib.constants.BROTLI_MAX_QUALITY,
+                [zlib.constants.BROTLI_PARAM_SIZE_HINT]: data.length
+            }
+        })
+    };
+}
+
+function writeAsset(name, text) {
+    const data = Buffer.from(text);
+    const { gzip, brotli } = compress(data);
+    writeFileSync(new URL(name, DIST), data);
+    writeFileSync(new URL(`${name}.gz`, DIST), gzip);
+    writeFileSync(new URL(`${name}.br`, DIST), brotli);
+    return { raw: data.length, gzip: gzip.length, brotli: brotli.length };
+}
+
+// DNS, TCP and TLS 1.3 handshakes and the request take a round trip each;
+// the response then grows from the initial window by doubling every round
+function networkMs(bytes, profile) {
+    let rounds = 4;
+    for (let window = INITIAL_WINDOW, sent = window; sent < bytes + HEADER_BYTES; sent += window) {
+        window *= 2;
+        rounds++;
+    }
+    return rounds * profile.rttMs + ((bytes + HEADER_BYTES) * 8 * 1000) / profile.bitsPerSecond;
+}
+
+function median(run) {
+    const samples = [];
+    for (let i = 0; i < RUNS; i++) {
+        const start = performance.now();
+        run();
+        samples.push(performance.now() - start);
+    }
+    samples.sort((a, b) => a - b);
+    return samples[samples.length >> 1];
+}
+
+// Compile the page's script and time what loadCheckpointData() does for one
+// runner before the first row is drawn. The DOM work after that is a few
+// dozen rows thanks to the virtual table and is left out.
+function measureScript(html, payload) {
+    const script = html.match(/<script>([\s\S]*?)<\/script>/)[1];
+    const context = vm.createContext({
+        atob,
+        btoa,
+        console,
+        document: { addEventListener() {} },
+        window: { addEventListener() {} }
+    });
+
+    let run = 0;
+    const compileMs = median(() => new vm.Script(`${script}\n// ${run++}`));  // Defeats V8's compile cache
+    new vm.Script(script).runInContext(context);
+    const analyseMs = median(() => context.analyseRun(payload));
+    const key = context.parseMacKey('00112233445566778899aabbccddeeff');
+    const macMs = median(() => context.pressTableMac(key, context.base64UrlDecode(payload)));
+    return { context, compileMs, analyseMs, macMs };
+}
+
+function samplePayload() {
+    const bytes = [SAMPLE_PRESSES.length - 2];
+    for (const [checkpoint, timestamp] of SAMPLE_PRESSES) {
+        bytes.push(checkpoint, (timestamp >> 16) & 0xff, (timestamp >> 8) & 0xff, timestamp & 0xff);
+    }
+    return Buffer.from(bytes).toString('base64url');
+}
+
+const sourceHtml = readFileSync(new URL('dump.html', SOURCE), 'utf8');
+const html = minifyHtml(sourceHtml);
+const build = createHash('sha256').update(html).digest('hex').slice(0, 12);
+const sw = minifyScript(readFileSync(new URL('sw.js', SOURCE), 'utf8')).replace('__BUILD__', build) + '\n';
+
+mkdirSync(DIST, { recursive: true });
+const page = writeAsset('dump.html', html);
+const worker = writeAsset('sw.js', sw);
+
+// The stripped script must still decode a readout exactly as the source does
+const payload = samplePayload();
+const built = measureScript(html, payload);
+const source = measureScript(sourceHtml, payload);
+const analysed = (context) => JSON.stringify(context.analyseRun(payload), (_, value) =>
+    ArrayBuffer.isView(value) ? Array.from(value) : value);
+if (analysed(built.context) !== analysed(source.context)) {
+    console.error('Built page analyses the sample readout differently from dump.html');
+    process.exit(1);
+}
+
+const scriptMs = built.compileMs + built.analyseMs;
+const kb = (bytes) => `${(bytes / 1024).toFixed(1)} KB`.padStart(9);
+const ms = (value) => `${value < 10 ? value.toFixed(1) : Math.round(value)} ms`.padStart(8);
+
+console.log(`build ${build}`);
+console.log(`page weight       source      raw     gzip   brotli`);
+console.log(`  dump.html    ${kb(Buffer.byteLength(sourceHtml))}${kb(page.raw)}${kb(page.gzip)}${kb(page.brotli)}`);
+console.log(`  sw.js        ${kb(Buffer.byteLength(readFileSync(new URL('sw.js', SOURCE))))}` +
+    `${kb(worker.raw)}${kb(worker.gzip)}${kb(worker.brotli)}`);
+console.log(`script         compile ${built.compileMs.toFixed(2)} ms, analyse ${built.analyseMs.toFixed(2)} ms, ` +
+    `MAC check ${built.macMs.toFixed(2)} ms (${SAMPLE_PRESSES.length} presses, median of ${RUNS})`);
+console.log(`time to render   uncompressed   brotli  offline (service worker)`);
+for (const profile of PROFILES) {
+    console.log(`  ${profile.name.padEnd(12)}${ms(networkMs(Buffer.byteLength(sourceHtml), profile) + scriptMs).padStart(15)}` +
+        `${ms(networkMs(page.brotli, profile) + scriptMs)}${ms(scriptMs)}`);
+}
+
+if (page.brotli > PAGE_BUDGET || page.gzip > PAGE_BUDGET) {
+    console.error(`dump.html is over ${PAGE_BUDGET} bytes compressed and no longer arrives in the first round trip`);
+    process.exit(1);
+}
@@ -0,0 +1,49 @@
+// Service worker for dump.html: keeps the page in the Cache Storage so a
+// runner who opened one dump can open the next one in the forest with no
+// signal. The page is self-contained, so caching it is enough for decoding
+// and rendering offline; only sending results needs the network.
+//
+// build.mjs replaces __BUILD__ with a hash of the built page, so every
+// deployment installs a fresh cache and drops the old one.
+
+const CACHE_PREFIX = 'kor-shell-';
+const CACHE = `${CACHE_PREFIX}__BUILD__`;
+const SHELL = new URL('dump.html', self.registration.scope).href;
+
+self.addEventListener('install', (event) => {
+    event.waitUntil(
+        caches.open(CACHE)
+            .then((cache) => cache.add(SHELL))
+            .then(() => self.skipWaiting())
+    );
+});
+
+self.addEventListener('activate', (event) => {
+    event.waitUntil(
+        caches.keys()
+            .then((keys) => Promise.all(keys
+                .filter((key) => key.startsWith(CACHE_PREFIX) && key !== CACHE)
+                .map((key) => caches.delete(key))))
+            .then(() => self.clients.claim())
+    );
+});
+
+// Every dump URL is the same page with a different query, so the cached
+// copy is matched without it. Cache first: on a weak signal the network is
+// only tried when the page is not cached yet.
+self.addEventListener('fetch', (event) => {
+    const request = event.request;
+    const url = new URL(request.url);
+    if (request.method !== 'GET' || url.origin + url.pathname !== SHELL) return;
+
+    event.respondWith(
+        caches.open(CACHE).then(async (cache) => {
+            const cached = await cache.match(SHELL);
+            if (cached) return cached;
+
+            const response = await fetch(request);
+            if (response.ok) await cache.put(SHELL, response.clone());
+            return response;
+        })
+    );
+});